@@ -0,0 +1,250 @@
+/*
+ * Benchmark for the optimal solver.
+ *
+ * Solves fixed, seeded sets of cubes: random states from create_random_cube()
+ * and random scrambles of fixed lengths. Results are printed as JSON, one
+ * object per line: one for each cube (including the nodes, lookups and time
+ * spent on each iteration of IDA*) and a summary for each set, including a
+ * histogram of solution lengths. Status messages go to stderr.
+ */
+#include "search.h"
+#include "parallel.h"
+#include "prune.h"
+#include "random.h"
+#include "coordinates.h"
+#include "cube.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_DEPTH QTM_DIAMETER
+
+// the most moves a cube can need in the metric being searched
+int diameter = HTM_DIAMETER;
+
+typedef struct {
+    const char *name;
+    int cubes;
+    int lengths[MAX_DEPTH + 1];
+    int unsolved;  // cubes with no solution within the diameter
+    SearchStats stats;
+    double seconds;
+} BenchSet;
+
+double seconds_between(struct timespec *start, struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+double per_second(uint64_t count, double seconds) {
+    return seconds > 0 ? count / seconds : 0;
+}
+
+// Random scramble of `length` moves, never turning the same face twice in a row or opposite faces out of order.
+Cube create_scramble(Rng *rng, int length) {
+
+    Cube cube = create_solved_cube();
+    int last_face = -1;
+
+    for(int i = 0; i < length; i++) {
+        int face;
+        do {
+            face = rng_below(rng, 6);
+        } while(last_face != -1 && is_redundant(last_face, face));
+        do_move(&cube, face, rng_below(rng, 3));
+        last_face = face;
+    }
+
+    return cube;
+
+}
+
+void bench_cube(BenchSet *set, Cube *cube, int num_threads) {
+
+    CoordCube coords = compute_coord_cube(cube);
+    int solution[32];
+    SearchContext ctx = {solution, NULL, {0, 0}};
+    int distance = lookup_pruning_table(&coords);
+    SearchNode node;
+    init_search_node(&node, &coords);
+
+    // start where solve_optimal() would, so that only the iterations it runs are measured
+    int bound = initial_search_bound(&coords, &node, &ctx.stats);
+
+    printf("{\"set\": \"%s\", \"cube\": %d, \"depths\": [", set->name, set->cubes);
+
+    double seconds = 0;
+    int length = is_coord_cube_solved(&coords) ? 0 : -1;
+
+    for(int depth = bound; length < 0 && depth <= diameter; depth++) {
+
+        SearchStats before = ctx.stats;
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        bool found = num_threads > 1 ? parallel_search(&ctx, &coords, depth, num_threads)
+                                     : search(&ctx, &node, distance, 0, depth);
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        double depth_seconds = seconds_between(&start, &end);
+        seconds += depth_seconds;
+        printf("%s{\"depth\": %d, \"nodes\": %llu, \"lookups\": %llu, \"seconds\": %.6f}",
+               depth == bound ? "" : ", ", depth,
+               (unsigned long long)(ctx.stats.nodes - before.nodes),
+               (unsigned long long)(ctx.stats.lookups - before.lookups), depth_seconds);
+
+        if(found) {
+            length = depth;
+        }
+
+    }
+
+    printf("], \"length\": %d, \"nodes\": %llu, \"lookups\": %llu, \"seconds\": %.6f, \"nodes_per_sec\": %.0f}\n",
+           length, (unsigned long long)ctx.stats.nodes, (unsigned long long)ctx.stats.lookups, seconds, per_second(ctx.stats.nodes, seconds));
+    fflush(stdout);
+
+    set->cubes++;
+    if(length < 0) {
+        set->unsolved++;
+    } else {
+        set->lengths[length]++;
+    }
+    set->stats.nodes += ctx.stats.nodes;
+    set->stats.lookups += ctx.stats.lookups;
+    set->seconds += seconds;
+
+}
+
+void print_summary(BenchSet *set) {
+
+    printf("{\"set\": \"%s\", \"summary\": true, \"cubes\": %d, \"unsolved\": %d, \"nodes\": %llu, \"lookups\": %llu, \"seconds\": %.6f, \"nodes_per_sec\": %.0f, \"lengths\": {",
+           set->name, set->cubes, set->unsolved, (unsigned long long)set->stats.nodes, (unsigned long long)set->stats.lookups,
+           set->seconds, per_second(set->stats.nodes, set->seconds));
+
+    bool first = true;
+    for(int i = 0; i <= MAX_DEPTH; i++) {
+        if(set->lengths[i] > 0) {
+            printf("%s\"%d\": %d", first ? "" : ", ", i, set->lengths[i]);
+            first = false;
+        }
+    }
+
+    printf("}}\n");
+    fflush(stdout);
+
+}
+
+void print_usage(const char *name) {
+    fprintf(stderr, "usage: %s [-h] [-r random_cubes] [-d min_depth:max_depth] [-n cubes_per_depth] [-S seed] [-j threads] [-f format] [-qceEisvH]\n", name);
+    fprintf(stderr, "  -h  print this help and exit\n");
+    fprintf(stderr, "  -r  number of random-state cubes to solve (default 0)\n");
+    fprintf(stderr, "  -d  range of scramble lengths (default 8:12)\n");
+    fprintf(stderr, "  -n  number of scrambles of each length (default 10)\n");
+    fprintf(stderr, "  -S  random seed (default 1)\n");
+    fprintf(stderr, "  -j  number of threads to search and build tables with (default 1)\n");
+    fprintf(stderr, "  -f  pruning table format: byte, nibble or mod3 (default byte)\n");
+    fprintf(stderr, "  -q  search in the quarter-turn metric (scrambles are still in face turns)\n");
+    fprintf(stderr, "  -c  also prune with the corner pattern database\n");
+    fprintf(stderr, "  -e  also prune with the edge pattern databases\n");
+    fprintf(stderr, "  -E  also prune with the E-slice pattern database\n");
+    fprintf(stderr, "  -i  also probe the pruning table with the inverse and rotated cube\n");
+    fprintf(stderr, "  -s  also prune with the symmetry-reduced flip-slice table\n");
+    fprintf(stderr, "  -v  verify the pruning table checksum when loading it\n");
+    fprintf(stderr, "  -H  ask for the pruning table to be backed by huge pages\n");
+}
+
+int main(int argc, char **argv) {
+
+    int random_cubes = 0, min_depth = 8, max_depth = 12, cubes_per_depth = 10, seed = 1;
+    // tables are always read in up front, so that page faults don't get timed as part of the first cubes
+    int num_threads = 1, format = PRUNE_BYTE, metric = METRIC_HTM, load_flags = PRUNE_LOAD_POPULATE;
+    bool symmetry = false, corners = false, edges = false, slice = false, probes = false;
+
+    int opt;
+    while((opt = getopt(argc, argv, "r:d:n:S:j:f:qceEisvHh")) != -1) {
+        switch(opt) {
+            case 'r': random_cubes = atoi(optarg); break;
+            case 'd':
+                if(sscanf(optarg, "%d:%d", &min_depth, &max_depth) != 2) {
+                    print_usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'n': cubes_per_depth = atoi(optarg); break;
+            case 'S': seed = atoi(optarg); break;
+            case 'j': num_threads = atoi(optarg); break;
+            case 'f': format = parse_prune_format(optarg); break;
+            case 'q': metric = METRIC_QTM; break;
+            case 'c': corners = true; break;
+            case 'e': edges = true; break;
+            case 'E': slice = true; break;
+            case 'i': probes = true; break;
+            case 's': symmetry = true; break;
+            case 'v': load_flags |= PRUNE_LOAD_VERIFY; break;
+            case 'H': load_flags |= PRUNE_LOAD_HUGEPAGES; break;
+            case 'h':
+                print_usage(argv[0]);
+                return 0;
+            default:
+                print_usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if(num_threads < 1 || format < 0 || min_depth < 0 || max_depth < min_depth) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    fprintf(stderr, "initializing coordinate multiplication tables...\n");
+    init_mult_tables();
+
+    fprintf(stderr, "initializing pruning tables...\n");
+    diameter = metric_diameter(metric);
+    init_pruning_table(format, metric, load_flags, num_threads);
+    if(corners) {
+        init_corner_pruning(load_flags, num_threads);
+    }
+    if(slice) {
+        init_slice_pruning(load_flags, num_threads);
+    }
+    if(edges) {
+        init_edge_pruning(load_flags, num_threads);
+    }
+    if(symmetry) {
+        init_symmetry_pruning(load_flags, num_threads);
+    }
+    if(probes) {
+        init_extra_probes();
+    }
+
+    // every set gets its own sequence, so changing the size of one set doesn't change the others
+    if(random_cubes > 0) {
+        BenchSet set = {"random"};
+        Rng rng;
+        seed_rng(&rng, seed);
+        for(int i = 0; i < random_cubes; i++) {
+            Cube cube = create_random_cube(&rng);
+            bench_cube(&set, &cube, num_threads);
+        }
+        print_summary(&set);
+    }
+
+    for(int depth = min_depth; depth <= max_depth; depth++) {
+        char name[32];
+        snprintf(name, sizeof(name), "depth%d", depth);
+        BenchSet set = {name};
+        Rng rng;
+        seed_rng(&rng, seed * 1000 + depth);
+        for(int i = 0; i < cubes_per_depth; i++) {
+            Cube cube = create_scramble(&rng, depth);
+            bench_cube(&set, &cube, num_threads);
+        }
+        print_summary(&set);
+    }
+
+    return 0;
+
+}
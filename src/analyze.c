@@ -0,0 +1,334 @@
+/*
+ * Pruning table analysis.
+ *
+ * Reads existing table files (any of them, whatever their coordinates) and
+ * prints how many entries are at each distance, without rebuilding anything.
+ * This is what to look at before deciding whether a heuristic is worth the
+ * memory.
+ *
+ * For each table we also estimate how many nodes IDA* would visit with it,
+ * using the formula of Korf, Reid and Edelkamp: a node at depth i of the
+ * search tree is expanded in the iteration with threshold d if its heuristic
+ * is at most d - i, so if N(i) is the number of canonical move sequences of
+ * length i and P(x) the fraction of entries at most x, the iteration visits
+ * about
+ *
+ *     sum over i from 0 to d of N(i) * P(d - i)
+ *
+ * nodes. This assumes that every entry stands for the same number of cubes,
+ * which holds for coordinate tables but not for symmetry-reduced ones like
+ * flipslice.prune, and it knows nothing about combining several tables.
+ *
+ * With -g, the arguments name tables to generate in memory instead (in the
+ * metric being estimated), so a heuristic can be sized up without building
+ * and saving it first. Generated tables are held one byte per entry, so any
+ * distance fits, and are reported under their names rather than a path.
+ *
+ * Output is JSON, one object per table, or CSV with one row per distance.
+ */
+#include "prune.h"
+#include "coordinates.h"
+#include "search.h"
+#include "symmetry.h"
+#include "cornerdb.h"
+#include "edgedb.h"
+#include "slicedb.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_THRESHOLD 32
+
+/*
+ * The number of canonical move sequences of each length, by the same rules
+ * the search uses: no turning the same face twice in a row or opposite faces
+ * out of order, except that in QTM a clockwise quarter turn may be repeated
+ * once.
+ */
+void count_sequences(int metric, int max_length, double *counts) {
+
+    const int *moves;
+    int num_moves = metric_moves(metric, &moves);
+
+    // sequences ending in each move, by whether that move repeated the one before it
+    double ending[2][18] = {{0}}, next[2][18];
+
+    counts[0] = 1;
+    for(int i = 0; i < num_moves; i++) {
+        ending[0][moves[i]] = 1;
+    }
+
+    for(int length = 1; length <= max_length; length++) {
+
+        counts[length] = 0;
+        for(int move = 0; move < 18; move++) {
+            counts[length] += ending[0][move] + ending[1][move];
+        }
+
+        memset(next, 0, sizeof(next));
+        for(int last = 0; last < 18; last++) {
+            for(int repeated = 0; repeated < 2; repeated++) {
+                if(ending[repeated][last] == 0) continue;
+                for(int i = 0; i < num_moves; i++) {
+                    int move = moves[i];
+                    if(metric == METRIC_QTM && move == last) {
+                        if(!repeated && move % 3 == TURN_CW) next[1][move] += ending[repeated][last];
+                    } else if(!is_redundant(last / 3, move / 3)) {
+                        next[0][move] += ending[repeated][last];
+                    }
+                }
+            }
+        }
+        memcpy(ending, next, sizeof(ending));
+
+    }
+
+}
+
+void print_json_string(const char *s, int max_length) {
+    putchar('"');
+    for(int i = 0; i < max_length && s[i] != '\0'; i++) {
+        if(s[i] == '"' || s[i] == '\\') putchar('\\');
+        putchar(s[i]);
+    }
+    putchar('"');
+}
+
+/*
+ * Print the distribution of a table (in byte or nibble format) and the IDA*
+ * estimates for it. `path` is whatever names the table in the output.
+ */
+void print_analysis(const char *path, const char *layout, PruneTable *table, int metric, int max_threshold, bool csv, int num_threads) {
+
+    fprintf(stderr, "analyzing %s...\n", path);
+    PruneDistribution dist;
+    prune_distribution(table, &dist, num_threads);
+
+    int unreached_value = table->format == PRUNE_NIBBLE ? 0xf : 0xff;
+    uint64_t unreached = dist.counts[unreached_value];
+    int max_distance = 0;
+    uint64_t sum = 0;
+    for(int i = 0; i < unreached_value; i++) {
+        if(dist.counts[i] > 0) max_distance = i;
+        sum += dist.counts[i] * i;
+    }
+
+    // cumulative[x] is P(x), the fraction of entries at most x
+    double cumulative[MAX_THRESHOLD + 1], sequences[MAX_THRESHOLD + 1], nodes[MAX_THRESHOLD + 1];
+    uint64_t at_most = 0;
+    for(int i = 0; i <= max_threshold; i++) {
+        at_most += i < unreached_value ? dist.counts[i] : 0;
+        cumulative[i] = (double)at_most / table->size;
+    }
+
+    count_sequences(metric, max_threshold, sequences);
+    for(int d = 0; d <= max_threshold; d++) {
+        nodes[d] = 0;
+        for(int i = 0; i <= d; i++) {
+            nodes[d] += sequences[i] * cumulative[d - i];
+        }
+    }
+
+    int rows = max_distance > max_threshold ? max_distance : max_threshold;
+    double mean = table->size > unreached ? (double)sum / (table->size - unreached) : 0;
+
+    if(csv) {
+        for(int i = 0; i <= rows; i++) {
+            printf("%s,%d,%llu,%.9f,", path, i, (unsigned long long)(i < unreached_value ? dist.counts[i] : 0),
+                   (double)(i < unreached_value ? dist.counts[i] : 0) / table->size);
+            if(i <= max_threshold) {
+                printf("%.9f,%.6g\n", cumulative[i], nodes[i]);
+            } else {
+                printf(",\n");
+            }
+        }
+    } else {
+        printf("{\"path\": ");
+        print_json_string(path, strlen(path));
+        printf(", \"layout\": ");
+        print_json_string(layout, strlen(layout));
+        printf(", \"format\": \"%s\", \"entries\": %llu, \"unreached\": %llu, \"max_distance\": %d, \"mean\": %.4f, \"counts\": [",
+               prune_format_name(table->format), (unsigned long long)table->size, (unsigned long long)unreached, max_distance, mean);
+        for(int i = 0; i <= max_distance; i++) {
+            printf(i == 0 ? "%llu" : ", %llu", (unsigned long long)dist.counts[i]);
+        }
+        printf("], \"metric\": \"%s\", \"ida_nodes\": [", metric == METRIC_QTM ? "qtm" : "htm");
+        for(int d = 0; d <= max_threshold; d++) {
+            printf(d == 0 ? "%.6g" : ", %.6g", nodes[d]);
+        }
+        printf("]}\n");
+    }
+    fflush(stdout);
+
+    /*
+     * Flip-slice entries are a class and a CO, and classes have different
+     * numbers of members, so its counts are of entries rather than cubes. A
+     * class fixed by some symmetries also has a twin entry for each way of
+     * conjugating CO, all holding the same distance. Tables generated before
+     * twins were filled in along with their canonical entry left them
+     * unreached.
+     */
+    if(strstr(layout, "flipslice-class") != NULL) {
+        fprintf(stderr, "note: %s counts entries rather than cubes, including the twin entries of classes fixed by a symmetry", path);
+        fprintf(stderr, unreached > 0 ? "; unreached entries are twins left by an older generator, so rebuild it\n" : "\n");
+    }
+
+}
+
+/*
+ * Analyze one table file, returning false if it can't be read or doesn't
+ * hold distances.
+ */
+bool analyze_table(const char *path, int metric, int max_threshold, bool csv, int flags, int num_threads) {
+
+    PruneFileHeader header;
+    int result = read_prune_header(path, &header);
+    if(result != PRUNE_OK) {
+        fprintf(stderr, "couldn't read %s: %s\n", path, prune_error_string(result));
+        return false;
+    }
+
+    if(header.format == PRUNE_MOD3) {
+        fprintf(stderr, "%s only stores distances mod 3; analyze the byte table it was packed from instead\n", path);
+        return false;
+    }
+
+    PruneTable table;
+    result = load_prune_table(&table, path, header.layout, header.size, header.format, flags);
+    if(result != PRUNE_OK) {
+        fprintf(stderr, "couldn't load %s: %s\n", path, prune_error_string(result));
+        return false;
+    }
+
+    // the header's layout isn't terminated if it fills the field
+    char layout[sizeof(header.layout) + 1];
+    memcpy(layout, header.layout, sizeof(header.layout));
+    layout[sizeof(header.layout)] = '\0';
+
+    print_analysis(path, layout, &table, metric, max_threshold, csv, num_threads);
+    free_prune_table(&table);
+    return true;
+
+}
+
+/*
+ * Look up a table to generate by name, doing whatever initialization its
+ * spec needs. Returns false if there is no such table.
+ */
+bool named_table_spec(const char *name, int metric, PruneSpec *spec) {
+
+    static bool symmetries_ready = false, edge_moves_ready = false;
+
+    if(strcmp(name, "main") == 0) {
+        main_table_spec(metric, spec);
+    } else if(strcmp(name, "corner") == 0) {
+        corner_table_spec(metric, spec);
+    } else if(strcmp(name, "edge0") == 0 || strcmp(name, "edge1") == 0) {
+        if(!edge_moves_ready) {
+            init_edge_moves();
+            edge_moves_ready = true;
+        }
+        edge_table_spec(name[4] - '0', metric, spec);
+    } else if(strcmp(name, "slice") == 0) {
+        slice_table_spec(metric, spec);
+    } else if(strcmp(name, "flipslice") == 0) {
+        if(!symmetries_ready) {
+            init_symmetries();
+            init_sym_coords();
+            symmetries_ready = true;
+        }
+        symmetry_table_spec(metric, spec);
+    } else {
+        return false;
+    }
+
+    return true;
+
+}
+
+// Generate a table in memory and analyze it, returning false if there is no such table.
+bool analyze_generated_table(const char *name, int metric, int max_threshold, bool csv, int num_threads) {
+
+    PruneSpec spec;
+    if(!named_table_spec(name, metric, &spec)) {
+        fprintf(stderr, "unknown table %s\n", name);
+        return false;
+    }
+
+    fprintf(stderr, "generating %s (%s)...\n", name, metric == METRIC_QTM ? "QTM" : "HTM");
+    PruneTable table;
+    alloc_prune_table(&table, spec.size, PRUNE_BYTE);
+    generate_prune_table(&spec, &table, num_threads);
+
+    print_analysis(name, spec.layout, &table, metric, max_threshold, csv, num_threads);
+    free_prune_table(&table);
+    return true;
+
+}
+
+void print_usage(const char *name) {
+    fprintf(stderr, "usage: %s [-j threads] [-d max_threshold] [-qcv] table.prune...\n", name);
+    fprintf(stderr, "       %s -g [-j threads] [-d max_threshold] [-qc] table...\n", name);
+    fprintf(stderr, "  -g  generate the named tables in memory instead: main, corner, edge0, edge1, edge (both), slice or flipslice\n");
+    fprintf(stderr, "  -j  number of threads to generate tables and count entries with (default 1)\n");
+    fprintf(stderr, "  -d  estimate IDA* nodes for thresholds up to this (default: the metric's diameter)\n");
+    fprintf(stderr, "  -q  estimate nodes for a quarter-turn metric search (and generate QTM tables)\n");
+    fprintf(stderr, "  -c  print CSV (path,distance,entries,fraction,cumulative,ida_nodes) instead of JSON\n");
+    fprintf(stderr, "  -v  verify each table's checksum when loading it\n");
+}
+
+int main(int argc, char **argv) {
+
+    int num_threads = 1, max_threshold = -1, metric = METRIC_HTM, flags = PRUNE_LOAD_POPULATE;
+    bool csv = false, generate = false;
+
+    int opt;
+    while((opt = getopt(argc, argv, "j:d:qcvg")) != -1) {
+        switch(opt) {
+            case 'g': generate = true; break;
+            case 'j': num_threads = atoi(optarg); break;
+            case 'd': max_threshold = atoi(optarg); break;
+            case 'q': metric = METRIC_QTM; break;
+            case 'c': csv = true; break;
+            case 'v': flags |= PRUNE_LOAD_VERIFY; break;
+            default:
+                print_usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if(max_threshold < 0) {
+        max_threshold = metric_diameter(metric);
+    }
+
+    if(optind >= argc || num_threads < 1 || max_threshold > MAX_THRESHOLD) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if(csv) {
+        printf("path,distance,entries,fraction,cumulative,ida_nodes\n");
+    }
+
+    if(generate) {
+        fprintf(stderr, "initializing coordinate multiplication tables...\n");
+        init_mult_tables();
+    }
+
+    bool ok = true;
+    for(int i = optind; i < argc; i++) {
+        if(!generate) {
+            ok &= analyze_table(argv[i], metric, max_threshold, csv, flags, num_threads);
+        } else if(strcmp(argv[i], "edge") == 0) {
+            ok &= analyze_generated_table("edge0", metric, max_threshold, csv, num_threads);
+            ok &= analyze_generated_table("edge1", metric, max_threshold, csv, num_threads);
+        } else {
+            ok &= analyze_generated_table(argv[i], metric, max_threshold, csv, num_threads);
+        }
+    }
+
+    return ok ? 0 : 1;
+
+}
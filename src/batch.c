@@ -0,0 +1,327 @@
+#include "batch.h"
+#include "search.h"
+#include "twophase.h"
+#include "coordinates.h"
+#include "statefile.h"
+#include "cube.h"
+#include <ctype.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// how many cubes each thread may have waiting or in progress
+#define JOBS_PER_THREAD 64
+
+typedef struct {
+    int line;
+    Cube cube;
+    bool valid;
+    bool done;
+    int length;
+    double ms;
+    bool searched;    // whether nodes and lower_bound were filled in by the optimal solver
+    uint64_t nodes;
+    int lower_bound;
+    int solution[32];
+} BatchJob;
+
+/*
+ * Jobs live in a ring buffer. Every job before `written` has been output,
+ * every job before `claimed` has been taken by a worker and every job before
+ * `read` has been read in.
+ */
+typedef struct {
+    BatchOptions *options;
+    StateFile *states_out;  // NULL when writing text
+    BatchJob *jobs;
+    int window;
+    long read;
+    long claimed;
+    long written;
+    bool eof;
+    pthread_mutex_t lock;
+    pthread_cond_t job_ready;
+    pthread_cond_t job_done;
+} BatchQueue;
+
+double milliseconds_since(struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1e3 + (now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+void solve_job(BatchOptions *options, BatchJob *job) {
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if(options->two_phase) {
+        job->length = solve_two_phase(&job->cube, options->max_length, options->time_limit_ms, job->solution);
+    } else {
+        // each cube gets one thread, so a hard one can only hold up its own worker
+        CoordCube coords = compute_coord_cube(&job->cube);
+        SearchBudget budget = {options->max_nodes, options->time_limit_ms};
+        OptimalResult result;
+        solve_optimal(&coords, &budget, 1, &result);
+        job->length = result.length;
+        memcpy(job->solution, result.solution, sizeof(job->solution));
+        job->searched = true;
+        job->nodes = result.stats.nodes;
+        job->lower_bound = result.lower_bound;
+    }
+
+    job->ms = milliseconds_since(&start);
+
+}
+
+void *batch_worker(void *arg) {
+
+    BatchQueue *queue = arg;
+
+    pthread_mutex_lock(&queue->lock);
+    while(true) {
+
+        while(queue->claimed == queue->read && !queue->eof) {
+            pthread_cond_wait(&queue->job_ready, &queue->lock);
+        }
+
+        if(queue->claimed == queue->read) {
+            break;
+        }
+
+        BatchJob *job = &queue->jobs[queue->claimed++ % queue->window];
+        if(!job->valid) {
+            // nothing to solve, but it can be written out now
+            pthread_cond_signal(&queue->job_done);
+            continue;
+        }
+
+        pthread_mutex_unlock(&queue->lock);
+
+        solve_job(queue->options, job);
+
+        pthread_mutex_lock(&queue->lock);
+        job->done = true;
+        pthread_cond_signal(&queue->job_done);
+
+    }
+    pthread_mutex_unlock(&queue->lock);
+
+    return NULL;
+
+}
+
+/*
+ * Output every finished job that isn't waiting on an earlier one. Jobs are
+ * only written once claimed, so that a worker never claims a slot which has
+ * been reused. Called with the lock held.
+ */
+void write_jobs(BatchQueue *queue, FILE *out) {
+
+    while(queue->written < queue->claimed) {
+
+        BatchJob *job = &queue->jobs[queue->written % queue->window];
+        if(!job->done) {
+            break;
+        }
+
+        if(queue->states_out != NULL) {
+            int error = write_state(queue->states_out, &job->cube, job->solution, job->length);
+            if(error != STATE_OK) {
+                fprintf(stderr, "failed to write state file: %s\n", state_error_string(error));
+                exit(1);
+            }
+            queue->written++;
+            continue;
+        }
+
+        fprintf(out, "%d\t%d\t%.3f\t", job->line, job->length, job->ms);
+        if(job->searched) {
+            fprintf(out, "%llu\t%d\t", (unsigned long long)job->nodes, job->lower_bound);
+        } else {
+            fprintf(out, "-\t-\t");
+        }
+        for(int i = 0; i < job->length; i++) {
+            fprintf(out, i == 0 ? "%s" : " %s", move_to_string(job->solution[i]));
+        }
+        fputc('\n', out);
+
+        queue->written++;
+
+    }
+
+}
+
+/*
+ * Parse a line as a facelet string if it's 54 characters with no spaces, and
+ * as a move sequence otherwise. Trailing whitespace is removed from `line`.
+ * Returns CUBE_VALID or an error code; for move sequences, the offset of the
+ * character in error is stored in `error_offset`, which is otherwise -1.
+ */
+int parse_line(char *line, Cube *cube, int *error_offset) {
+
+    int length = strlen(line);
+    while(length > 0 && isspace((unsigned char)line[length - 1])) {
+        line[--length] = '\0';
+    }
+
+    *error_offset = -1;
+    if(length == 54 && strchr(line, ' ') == NULL) {
+        return parse_facelets(cube, line);
+    }
+
+    *cube = create_solved_cube();
+    return do_moves(cube, line, error_offset);
+
+}
+
+/*
+ * Read the next cube from text input into `job`, returning false at the end
+ * of the input. `line` and `capacity` are the getline() buffer.
+ */
+bool read_text_job(FILE *in, char **line, size_t *capacity, int *line_number, BatchJob *job) {
+
+    while(getline(line, capacity, in) != -1) {
+
+        (*line_number)++;
+
+        char *text = *line;
+        while(isspace((unsigned char)*text)) text++;
+        if(*text == '\0' || *text == '#') {
+            continue;
+        }
+
+        int offset, error = parse_line(text, &job->cube, &offset);
+        job->line = *line_number;
+        job->valid = error == CUBE_VALID;
+        job->done = !job->valid;
+        job->length = -1;
+        job->ms = 0;
+        job->searched = false;
+        if(offset >= 0) {
+            // count columns from the start of the line, before leading whitespace was skipped
+            fprintf(stderr, "line %d, column %d: %s\n", *line_number, (int)(text - *line) + offset + 1, cube_error_string(error));
+        } else if(error != CUBE_VALID) {
+            fprintf(stderr, "line %d: %s\n", *line_number, cube_error_string(error));
+        }
+        return true;
+
+    }
+
+    return false;
+
+}
+
+// Read the next cube from a state file into `job`, returning false at the end of the file.
+bool read_state_job(StateFile *file, BatchJob *job) {
+
+    int error = read_state(file, &job->cube, NULL, NULL);
+    if(error == STATE_END) {
+        return false;
+    }
+    if(error != STATE_OK) {
+        fprintf(stderr, "record %llu: %s\n", (unsigned long long)file->records + 1, state_error_string(error));
+        exit(1);
+    }
+
+    job->line = file->records;
+    job->valid = true;
+    job->done = false;
+    job->length = -1;
+    job->ms = 0;
+    job->searched = false;
+    return true;
+
+}
+
+void solve_batch(FILE *in, FILE *out, BatchOptions *options) {
+
+    StateFile states_in, states_out;
+    if(options->state_files) {
+        int error = read_state_header(&states_in, in);
+        if(error == STATE_OK) {
+            error = write_state_header(&states_out, out, STATE_FILE_SOLUTIONS);
+        }
+        if(error != STATE_OK) {
+            fprintf(stderr, "failed to start reading state file: %s\n", state_error_string(error));
+            exit(1);
+        }
+    }
+
+    BatchQueue queue;
+    queue.options = options;
+    queue.states_out = options->state_files ? &states_out : NULL;
+    queue.window = options->num_threads * JOBS_PER_THREAD;
+    queue.jobs = malloc(queue.window * sizeof(BatchJob));
+    queue.read = queue.claimed = queue.written = 0;
+    queue.eof = false;
+    pthread_mutex_init(&queue.lock, NULL);
+    pthread_cond_init(&queue.job_ready, NULL);
+    pthread_cond_init(&queue.job_done, NULL);
+
+    pthread_t *threads = malloc(options->num_threads * sizeof(pthread_t));
+    for(int i = 0; i < options->num_threads; i++) {
+        if(pthread_create(&threads[i], NULL, batch_worker, &queue) != 0) {
+            perror("failed to create batch thread");
+            exit(1);
+        }
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    char *line = NULL;
+    size_t capacity = 0;
+    int line_number = 0;
+    BatchJob job;
+    while(options->state_files ? read_state_job(&states_in, &job)
+                               : read_text_job(in, &line, &capacity, &line_number, &job)) {
+
+        pthread_mutex_lock(&queue.lock);
+
+        // wait for room in the window
+        while(queue.read - queue.written == queue.window) {
+            write_jobs(&queue, out);
+            if(queue.read - queue.written == queue.window) {
+                pthread_cond_wait(&queue.job_done, &queue.lock);
+            }
+        }
+
+        queue.jobs[queue.read % queue.window] = job;
+        queue.read++;
+        pthread_cond_signal(&queue.job_ready);
+
+        write_jobs(&queue, out);
+        pthread_mutex_unlock(&queue.lock);
+
+    }
+
+    free(line);
+
+    pthread_mutex_lock(&queue.lock);
+    queue.eof = true;
+    pthread_cond_broadcast(&queue.job_ready);
+    while(true) {
+        write_jobs(&queue, out);
+        if(queue.written == queue.read) break;
+        pthread_cond_wait(&queue.job_done, &queue.lock);
+    }
+    pthread_mutex_unlock(&queue.lock);
+
+    for(int i = 0; i < options->num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    fflush(out);
+    double seconds = milliseconds_since(&start) / 1e3;
+    fprintf(stderr, "solved %ld cubes in %.2fs (%.1f cubes/s)\n", queue.read, seconds, queue.read / seconds);
+
+    pthread_mutex_destroy(&queue.lock);
+    pthread_cond_destroy(&queue.job_ready);
+    pthread_cond_destroy(&queue.job_done);
+    free(queue.jobs);
+    free(threads);
+
+}
@@ -0,0 +1,47 @@
+#ifndef __BATCH_H
+#define __BATCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Batch solving.
+ *
+ * Loading the tables takes far longer than solving a single cube, so for
+ * large workloads we load them once and stream cubes through a pool of
+ * threads. Each input line is either a move sequence or the 54 facelet colors
+ * in the order of get_cube_colors() (which is what print_cube() prints without
+ * a terminal, read row by row), written without spaces. Blank lines and lines
+ * starting with '#' are skipped.
+ *
+ * Solutions are written in input order, one tab-separated line per cube:
+ *
+ *     <input line number> <length> <milliseconds> <nodes> <lower bound> <solution>
+ *
+ * A length of -1 means the cube couldn't be parsed or no solution was found,
+ * which for the optimal solver means the cube's node or time budget ran out.
+ * `nodes` is how many nodes the optimal solver searched and `lower bound` the
+ * length it proved no shorter solution exists below (see OptimalResult), so a
+ * cube that ran out of budget still says how far it got. Both are - for the
+ * two-phase solver and for cubes that couldn't be parsed.
+ * Only a window of cubes is held in memory at once, so the input can be
+ * arbitrarily long.
+ *
+ * With `state_files`, the input is instead a state file (see statefile.h),
+ * and the output is a state file with solutions holding the same cubes in
+ * the same order, with no solution for cubes the solver gave up on.
+ */
+
+typedef struct {
+    bool two_phase;
+    int max_length;     // two-phase only
+    int time_limit_ms;  // per cube; for the optimal solver, 0 means no limit
+    uint64_t max_nodes; // per cube, optimal only; 0 for no limit
+    int num_threads;
+    bool state_files;   // read and write state files instead of text
+} BatchOptions;
+
+void solve_batch(FILE *in, FILE *out, BatchOptions *options);
+
+#endif
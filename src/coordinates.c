@@ -1,17 +1,29 @@
 #include "coordinates.h"
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
-unsigned int *co_mult_table;
-unsigned int *eo_mult_table;
-
-unsigned int *eslice_seq2perm_table;
+uint16_t *co_mult_table;
+uint16_t *eo_mult_table;
+uint16_t *cp_mult_table;
+uint16_t *eslice_mult_table;
+uint16_t *ud_edge_mult_table;
+uint16_t *ec_mult_table;
 
 // convert move to integer {0..17}
 int move_to_int(int  face, int degree) {
     return face * 3 + degree;
 }
 
+// name of a move in standard notation
+const char *move_to_string(int move) {
+    static const char *names[18] = {
+        "U", "U'", "U2", "D", "D'", "D2", "L", "L'", "L2",
+        "R", "R'", "R2", "B", "B'", "B2", "F", "F'", "F2"
+    };
+    return names[move];
+}
+
 /*
  * The orientation of the last corner cubie depends on the orientation of the
  * others, so there are only really 7 degrees of freedom.
@@ -33,6 +45,24 @@ int compute_eo_coord(Cube *cube) {
     return coord;
 }
 
+void set_co_coord(Cube *cube, int co) {
+    int total = 0;
+    for(int i = 0; i < 7; i++, co /= 3) {
+        cube->corner_orientations[cube->corners[i]] = co % 3;
+        total += co % 3;
+    }
+    cube->corner_orientations[cube->corners[7]] = (3 - total % 3) % 3;
+}
+
+void set_eo_coord(Cube *cube, int eo) {
+    int total = 0;
+    for(int i = 0; i < 11; i++) {
+        cube->edge_orientations[cube->edges[i]] = (eo >> i) & 1;
+        total += (eo >> i) & 1;
+    }
+    cube->edge_orientations[cube->edges[11]] = total % 2;
+}
+
 int compute_ec_coord(Cube *cube) {
 
     int edge_pos = 0, corner_pos = 0;
@@ -55,51 +85,259 @@ int compute_ec_coord(Cube *cube) {
 
 }
 
+/*
+ * Cubies are ranked using the Lehmer code of their permutation; the solved
+ * permutation always maps to 0.
+ */
+int rank_permutation(uint8_t *perm, int n) {
+    int rank = 0;
+    for(int i = 0; i < n; i++) {
+        int smaller = 0;
+        for(int j = i + 1; j < n; j++) {
+            if(perm[j] < perm[i]) smaller++;
+        }
+        rank = rank * (n - i) + smaller;
+    }
+    return rank;
+}
+
+void unrank_permutation(int rank, uint8_t *perm, int n) {
+
+    // extract the digits of the Lehmer code, least significant first
+    int digits[12];
+    for(int i = n - 1; i >= 0; i--) {
+        digits[i] = rank % (n - i);
+        rank /= n - i;
+    }
+
+    // pick the unused elements one by one
+    int used_mask = 0;
+    for(int i = 0; i < n; i++) {
+        int skip = digits[i];
+        for(int value = 0; value < n; value++) {
+            if(used_mask & (1 << value)) continue;
+            if(skip-- == 0) {
+                perm[i] = value;
+                used_mask |= 1 << value;
+                break;
+            }
+        }
+    }
+
+}
+
+int binomial(int n, int k) {
+    if(k < 0 || k > n) return 0;
+    int result = 1;
+    for(int i = 0; i < k; i++) {
+        result = result * (n - i) / (i + 1);
+    }
+    return result;
+}
+
+int compute_cp_coord(Cube *cube) {
+    return rank_permutation(cube->corners, 8);
+}
+
+// CP and CO together, which pin down every corner: cp * 2187 + co.
+int compute_corner_coord(Cube *cube) {
+    return compute_cp_coord(cube) * 2187 + compute_co_coord(cube);
+}
+
+/*
+ * The E-slice coordinate tracks the positions of the four E-slice edges (FL,
+ * FR, BL and BR) and the order they appear in, giving 12P4 = 11880 values. We
+ * split it into the combination of positions occupied by the slice edges (12C4
+ * = 495 values) and the permutation of the slice edges within those positions
+ * (4! = 24 values), so that coord / 24 tells us whether the slice edges are
+ * in the E-slice and coord % 24 tells us how they're arranged. The combination
+ * is ranked backwards from position 11 so that a solved cube has coordinate 0.
+ *
+ * Nothing about this depends on which four edges we track, so the same
+ * coordinate (and move table) also works for the U and D layer edges.
+ */
+int compute_edge4_coord(Cube *cube, int first_edge) {
+
+    int comb = 0, found = 0;
+    uint8_t order[4];
+
+    for(int pos = 11; pos >= 0; pos--) {
+        int edge = cube->edges[pos];
+        if(edge >= first_edge && edge < first_edge + 4) {
+            comb += binomial(11 - pos, found + 1);
+            order[3 - found] = edge - first_edge;
+            found++;
+        }
+    }
+
+    return comb * 24 + rank_permutation(order, 4);
+
+}
+
 int compute_eslice_coord(Cube *cube) {
+    return compute_edge4_coord(cube, FL);
+}
 
-    
+// Arrange the E-slice edges on a cube according to an E-slice coordinate.
+void set_eslice_coord(Cube *cube, int coord) {
+
+    uint8_t order[4];
+    unrank_permutation(coord % 24, order, 4);
+
+    // Walk the combinatorial number system back down to recover positions.
+    int comb = coord / 24, found = 4;
+    bool slice_pos[12] = {false};
+    for(int pos = 0; pos < 12 && found > 0; pos++) {
+        int value = binomial(11 - pos, found);
+        if(comb >= value) {
+            comb -= value;
+            slice_pos[pos] = true;
+            found--;
+        }
+    }
 
+    int next_slice = 0, next_other = 0;
+    for(int pos = 0; pos < 12; pos++) {
+        if(slice_pos[pos]) {
+            cube->edges[pos] = FL + order[next_slice++];
+        } else {
+            cube->edges[pos] = next_other++;
+        }
+    }
+
+}
+
+/*
+ * Phase 2 of the two-phase algorithm only uses moves which keep the U and D
+ * layer edges within those layers, so we can rank them as a permutation of 8.
+ * This coordinate is meaningless outside of <U,D,L2,R2,F2,B2>.
+ */
+int compute_ud_edge_coord(Cube *cube) {
+    return rank_permutation(cube->edges, 8);
 }
 
-int init_eslice_mult_table(Cube *cube) {
+bool is_phase2_move(int move) {
+    int face = move / 3, degree = move % 3;
+    return face == FACE_U || face == FACE_D || degree == TURN_FLIP;
+}
 
-    unsigned int *eslice_perm2seq_table = malloc(11880 * sizeof(unsigned int)); // 12p4 = 11880
-    eslice_seq2perm_table = malloc(20736 * sizeof(unsigned int)); // 12^4 = 20736
+/*
+ * The moves of a metric, returning how many there are. Both sets are closed
+ * under inverses, which generate_prune_table() relies on.
+ */
+int metric_moves(int metric, const int **moves) {
+    static const int htm[18] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17};
+    static const int qtm[12] = {0, 1, 3, 4, 6, 7, 9, 10, 12, 13, 15, 16};
+    *moves = metric == METRIC_QTM ? qtm : htm;
+    return metric == METRIC_QTM ? 12 : 18;
+}
 
-    // Generate all possible 12P4 in a rather stupid way.
-    int perm = 0;
-    for(int i0 = 0; i0 < 12; i0++) {   
-        for(int i1 = 0; i1 < 12; i1++) {
-            if(i1 == i0) continue;
-            for(int i2 = 0; i2 < 12; i2++) {
-                if(i2 == i0 || i2 == i1) continue;
-                for(int i3 = 0; i3 < 12; i3++) {
-                    if(i3 == i0 || i3 == i1 || i3 == i2) continue;
-                    
-                    int seq = i0 + i1 * 12 + i2 * 144 + i3 * 1728;
-                    eslice_seq2perm_table[seq] = perm;
-                    eslice_perm2seq_table[perm] = seq;
+int metric_diameter(int metric) {
+    return metric == METRIC_QTM ? QTM_DIAMETER : HTM_DIAMETER;
+}
 
-                    perm++;
+// Moves on the same face, and moves on opposite faces in the wrong order, are redundant.
+bool is_redundant(int last_face, int face) {
+    return last_face == face ||
+           (last_face == FACE_D && face == FACE_U) ||
+           (last_face == FACE_R && face == FACE_L) ||
+           (last_face == FACE_B && face == FACE_F);
+}
 
-                }
-            }
+// A zeroed move table for `coords` values, starting on a cache line.
+uint16_t *alloc_mult_table(int coords) {
+    size_t size = (coords * 18 * sizeof(uint16_t) + 63) / 64 * 64;
+    uint16_t *table = aligned_alloc(64, size);
+    if(table == NULL) {
+        perror("failed to allocate move table");
+        exit(1);
+    }
+    memset(table, 0, size);
+    return table;
+}
+
+/*
+ * The move tables are built by setting up a cube with each value of the
+ * coordinate and multiplying it by the cube for each move.
+ */
+void fill_mult_table(uint16_t *table, int coord, Cube *cube, int (*compute)(Cube *)) {
+    for(int move = 0; move < 18; move++) {
+        Cube next;
+        cube_multiply(cube, &move_cubes[move], &next);
+        table[coord * 18 + move] = compute(&next);
+    }
+}
+
+void init_cp_mult_table() {
+
+    cp_mult_table = alloc_mult_table(40320); // 8! = 40320
+
+    for(int coord = 0; coord < 40320; coord++) {
+        Cube cube = create_solved_cube();
+        unrank_permutation(coord, cube.corners, 8);
+        fill_mult_table(cp_mult_table, coord, &cube, compute_cp_coord);
+    }
+
+}
+
+void init_eslice_mult_table() {
+
+    eslice_mult_table = alloc_mult_table(11880); // 12P4 = 11880
+
+    for(int coord = 0; coord < 11880; coord++) {
+        Cube cube = create_solved_cube();
+        set_eslice_coord(&cube, coord);
+        fill_mult_table(eslice_mult_table, coord, &cube, compute_eslice_coord);
+    }
+
+}
+
+// Only the entries for phase 2 moves are filled in.
+void init_ud_edge_mult_table() {
+
+    ud_edge_mult_table = alloc_mult_table(40320);
+
+    for(int coord = 0; coord < 40320; coord++) {
+        Cube cube = create_solved_cube();
+        unrank_permutation(coord, cube.edges, 8);
+        for(int move = 0; move < 18; move++) {
+            if(!is_phase2_move(move)) continue;
+            Cube next;
+            cube_multiply(&cube, &move_cubes[move], &next);
+            ud_edge_mult_table[coord * 18 + move] = compute_ud_edge_coord(&next);
         }
     }
 
-    // Create multiplication tables for the e-slice raw coordinate
+}
+
+void init_ec_mult_table() {
+
+    ec_mult_table = alloc_mult_table(96); // 8 * 12 = 96
+
+    for(int corner_pos = 0; corner_pos < 8; corner_pos++) {
+        for(int edge_pos = 0; edge_pos < 12; edge_pos++) {
+
+            // move corner 0 and edge 0 into place
+            Cube cube = create_solved_cube();
+            cube.corners[0] = cube.corners[corner_pos];
+            cube.corners[corner_pos] = 0;
+            cube.edges[0] = cube.edges[edge_pos];
+            cube.edges[edge_pos] = 0;
+
+            fill_mult_table(ec_mult_table, corner_pos * 12 + edge_pos, &cube, compute_ec_coord);
 
-    free(eslice_perm2seq_table);
+        }
+    }
 
 }
 
 void init_co_mult_table() {
 
-    co_mult_table = malloc(18 * 2187 * sizeof(unsigned int)); // 3^7 = 2187
+    co_mult_table = alloc_mult_table(2187); // 3^7 = 2187
 
     for(int coord = 0; coord < 2187; coord++) {
 
-        uint8_t corner_orientation[8];
+        Cube cube = create_solved_cube();
         int coord_copy = coord, total_co = 0;
         
         /*
@@ -109,122 +347,109 @@ void init_co_mult_table() {
          */
         for(int i = 0; i < 7; i++) {
             int co = coord_copy % 3;
-            corner_orientation[i] = co;
+            cube.corner_orientations[i] = co;
             total_co += co;
             coord_copy /= 3;
         }
 
-        corner_orientation[7] = (3 - total_co % 3) % 3;
-        
-        for(int face = 0; face < 6; face++) {
-            for(int degree = 0; degree < 3; degree++) {
-
-                // convert the coordinate into a cube
-                Cube cube = create_solved_cube();
-                memcpy(cube.corner_orientations, corner_orientation, 8);
+        cube.corner_orientations[7] = (3 - total_co % 3) % 3;
+        fill_mult_table(co_mult_table, coord, &cube, compute_co_coord);
 
-                // calculate new coordinate and store in table
-                do_move(&cube, face, degree);
-                co_mult_table[coord * 18 + move_to_int(face, degree)] = compute_co_coord(&cube);
-
-            }
-        }
     }
 
 }
 
 void init_eo_mult_table() {
 
-    eo_mult_table = malloc(18 * 2048 * sizeof(unsigned int)); // 2^11 ^ 2048
+    eo_mult_table = alloc_mult_table(2048); // 2^11 ^ 2048
 
     for(int coord = 0; coord < 2048; coord++) {
 
-        uint8_t edge_orientation[12];
+        Cube cube = create_solved_cube();
         int total_eo = 0;
 
         for(int i = 0; i < 11; i++) {
             int eo = (coord >> i) & 1;
-            edge_orientation[i] = eo;
+            cube.edge_orientations[i] = eo;
             total_eo += eo;
         }
 
-        edge_orientation[11] = total_eo % 1;
+        cube.edge_orientations[11] = total_eo % 2;
+        fill_mult_table(eo_mult_table, coord, &cube, compute_eo_coord);
 
-        for(int face = 0; face < 6; face++) {
-            for(int degree = 0; degree < 3; degree++) {
-                Cube cube = create_solved_cube();
-                memcpy(cube.edge_orientations, edge_orientation, 12);
-                do_move(&cube, face, degree);
-                eo_mult_table[coord * 18 + move_to_int(face, degree)] = compute_eo_coord(&cube);
-            }
-        }
     }
 
 }
 
+CoordCube solved_coords;
+
+CoordCube compute_coord_cube(Cube *cube) {
+    CoordCube coords;
+    coords.co = compute_co_coord(cube);
+    coords.eo = compute_eo_coord(cube);
+    coords.cp = compute_cp_coord(cube);
+    coords.ec = compute_ec_coord(cube);
+    coords.u_edges = compute_edge4_coord(cube, UL);
+    coords.d_edges = compute_edge4_coord(cube, DL);
+    coords.e_edges = compute_edge4_coord(cube, FL);
+    return coords;
+}
 
-/*
-void permute_corners(uint8_t *corners, int k) {
-
-    if(k == 1) {
-
-        for(int face = 0; face < 6; face++) {
-            for(int degree = 0; degree < 3; degree++) {
-
-                Cube cube = create_solved_cube();
-                memcpy(&cube.corners, corners, 8);
-                int coord = compute_cp_coord(&cube);
+// The inverse of compute_coord_cube(); ec is implied by the other coordinates.
+Cube coord_cube_to_cube(CoordCube *coords) {
 
-                do_move(&cube, face, degree);
-                cp_mult_table[coord * 18 + move_to_int(face, degree)] = compute_cp_coord(&cube);
+    Cube cube;
+    unrank_permutation(coords->cp, cube.corners, 8);
 
+    // the 12P4 coordinates place their four edges the same way whichever edges they track
+    int groups[3] = {coords->u_edges, coords->d_edges, coords->e_edges};
+    for(int group = 0; group < 3; group++) {
+        Cube slice = create_solved_cube();
+        set_eslice_coord(&slice, groups[group]);
+        for(int pos = 0; pos < 12; pos++) {
+            if(slice.edges[pos] >= FL) {
+                cube.edges[pos] = slice.edges[pos] - FL + group * 4;
             }
         }
-        
-    } else {
-
-        permute_corners(corners, k - 1);
-        for(int i = 0; i < k - 1; i++) {
-            if(k % 2) {
-                int tmp = corners[0];
-                corners[0] = corners[k - 1];
-                corners[k - 1] = tmp;
-            } else {
-                int tmp = corners[i];
-                corners[i] = corners[k - 1];
-                corners[k - 1] = tmp;
-            }
-            permute_corners(corners, k - 1);
-        }
-
     }
 
-}
+    set_co_coord(&cube, coords->co);
+    set_eo_coord(&cube, coords->eo);
+    return cube;
 
-void init_cp_mult_table() {
-
-    cp_mult_table = malloc(18 * 40320 * sizeof(unsigned int)); // 8! = 40320
+}
 
-    uint8_t corners[] = {0, 1, 2, 3, 4, 5, 6, 7};
-    permute_corners(corners, 8);
+void mult_coord_cube(CoordCube *cube, int move, CoordCube *result) {
+    result->co = co_mult_table[cube->co * 18 + move];
+    result->eo = eo_mult_table[cube->eo * 18 + move];
+    result->cp = cp_mult_table[cube->cp * 18 + move];
+    result->ec = ec_mult_table[cube->ec * 18 + move];
+    result->u_edges = eslice_mult_table[cube->u_edges * 18 + move];
+    result->d_edges = eslice_mult_table[cube->d_edges * 18 + move];
+    result->e_edges = eslice_mult_table[cube->e_edges * 18 + move];
+}
 
+/*
+ * The corner coordinates and the three edge coordinates together pin down
+ * every cubie, so the cube is solved exactly when they match a solved cube.
+ * (`ec` is implied by the rest.)
+ */
+bool is_coord_cube_solved(CoordCube *cube) {
+    return cube->co == 0 && cube->eo == 0 && cube->cp == 0 &&
+           cube->u_edges == solved_coords.u_edges &&
+           cube->d_edges == solved_coords.d_edges &&
+           cube->e_edges == 0;
 }
-*/
 
 void init_mult_tables() {
+    init_move_cubes();
     init_co_mult_table();
     init_eo_mult_table();
+    init_cp_mult_table();
+    init_eslice_mult_table();
+    init_ud_edge_mult_table();
     init_ec_mult_table();
-}
 
-int mult_co(int co, int move) {
-    return co_mult_table[co * 18 + move];
+    Cube solved = create_solved_cube();
+    solved_coords = compute_coord_cube(&solved);
 }
-
-int mult_eo(int eo, int move) {
-    return eo_mult_table[eo * 18 + move];
-}
-
-int mult_ec(int ec, int move) {
-    return ec_mult_table[ec * 18 + move];
-}
\ No newline at end of file
@@ -52,13 +52,99 @@
  * states and maps them to the same value.
  */
 
+#define CORNER_COORDS 88179840 // 8! * 3^7
+
+/*
+ * Metrics. In the half-turn metric (HTM) any turn of a face counts as one
+ * move; in the quarter-turn metric (QTM) only quarter turns do, and a half
+ * turn counts as two. Move tables cover all 18 HTM moves, of which the QTM
+ * moves are a subset.
+ */
+#define METRIC_HTM 0
+#define METRIC_QTM 1
+
+// the most moves any cube needs in each metric
+#define HTM_DIAMETER 20
+#define QTM_DIAMETER 26
+
+/*
+ * A cube state expressed as coordinates, so that moves can be applied with
+ * table lookups instead of shuffling cubies around. The edge permutation is
+ * split into the positions of the U layer, D layer and E-slice edges.
+ */
+typedef struct {
+    uint16_t co;
+    uint16_t eo;
+    uint16_t cp;
+    uint16_t ec;
+    uint16_t u_edges;
+    uint16_t d_edges;
+    uint16_t e_edges;
+} CoordCube;
+
 void init_mult_tables();
+CoordCube compute_coord_cube(Cube *cube);
+Cube coord_cube_to_cube(CoordCube *coords);
+void mult_coord_cube(CoordCube *cube, int move, CoordCube *result);
+bool is_coord_cube_solved(CoordCube *cube);
 int compute_co_coord(Cube *cube);
 int compute_eo_coord(Cube *cube);
+void set_co_coord(Cube *cube, int co);
+void set_eo_coord(Cube *cube, int eo);
 int compute_ec_coord(Cube *cube);
-int mult_co(int co, int move);
-int mult_eo(int cp, int move);
-int mult_ec(int ec, int move);
+int compute_cp_coord(Cube *cube);
+int compute_corner_coord(Cube *cube);
+int compute_eslice_coord(Cube *cube);
+int compute_edge4_coord(Cube *cube, int first_edge);
+int compute_ud_edge_coord(Cube *cube);
+void set_eslice_coord(Cube *cube, int coord);
+int rank_permutation(uint8_t *perm, int n);
+void unrank_permutation(int rank, uint8_t *perm, int n);
+bool is_phase2_move(int move);
+bool is_redundant(int last_face, int face);
+int metric_moves(int metric, const int **moves);
+int metric_diameter(int metric);
 int move_to_int(int face, int degree);
+const char *move_to_string(int move);
+
+/*
+ * Move tables, laid out as coord * 18 + move. Every coordinate fits in 16
+ * bits, and each table starts on a cache line. The accessors are inline so
+ * that the search doesn't pay for a call on every lookup.
+ */
+extern uint16_t *co_mult_table;
+extern uint16_t *eo_mult_table;
+extern uint16_t *cp_mult_table;
+extern uint16_t *eslice_mult_table;
+extern uint16_t *ud_edge_mult_table;
+extern uint16_t *ec_mult_table;
+
+static inline int mult_co(int co, int move) {
+    return co_mult_table[co * 18 + move];
+}
+
+static inline int mult_eo(int eo, int move) {
+    return eo_mult_table[eo * 18 + move];
+}
+
+static inline int mult_ec(int ec, int move) {
+    return ec_mult_table[ec * 18 + move];
+}
+
+static inline int mult_cp(int cp, int move) {
+    return cp_mult_table[cp * 18 + move];
+}
+
+static inline int mult_corner(int corner, int move) {
+    return cp_mult_table[corner / 2187 * 18 + move] * 2187 + co_mult_table[corner % 2187 * 18 + move];
+}
+
+static inline int mult_eslice(int eslice, int move) {
+    return eslice_mult_table[eslice * 18 + move];
+}
+
+static inline int mult_ud_edge(int ud_edge, int move) {
+    return ud_edge_mult_table[ud_edge * 18 + move];
+}
 
 #endif
\ No newline at end of file
@@ -0,0 +1,48 @@
+#include "cornerdb.h"
+#include "prune.h"
+#include <stdio.h>
+
+#define CORNER_LAYOUT "cp:40320 co:2187"
+
+PruneTable corner_table;
+
+void corner_table_neighbours(uint64_t index, const int *moves, int num_moves, uint64_t *out) {
+    for(int i = 0; i < num_moves; i++) {
+        out[i] = mult_corner(index, moves[i]);
+    }
+}
+
+// How to generate the table for `metric`, without checkpoints.
+void corner_table_spec(int metric, PruneSpec *spec) {
+    const int *moves;
+    int num_moves = metric_moves(metric, &moves);
+    *spec = (PruneSpec){CORNER_COORDS, 0, moves, num_moves, corner_table_neighbours, NULL, CORNER_LAYOUT};
+}
+
+void init_corner_table(int flags, int num_threads) {
+
+    const char *path = "cornerdb.prune";
+    fprintf(stderr, "loading pruning table %s...\n", path);
+
+    int result = load_prune_table(&corner_table, path, CORNER_LAYOUT, CORNER_COORDS, PRUNE_NIBBLE, flags);
+    if(result == PRUNE_OK) {
+        return;
+    }
+
+    fprintf(stderr, "couldn't load pruning table %s: %s\n", path, prune_error_string(result));
+    fprintf(stderr, "building corner pattern database...\n");
+
+    PruneSpec spec;
+    corner_table_spec(METRIC_HTM, &spec);
+    spec.path = path;
+
+    alloc_prune_table(&corner_table, CORNER_COORDS, PRUNE_NIBBLE);
+    generate_prune_table(&spec, &corner_table, num_threads);
+    save_prune_table(&corner_table, path, CORNER_LAYOUT);
+
+}
+
+// Exact number of moves needed to solve the corners of a cube.
+int lookup_corner_table(CoordCube *cube) {
+    return prune_get(&corner_table, (uint64_t)cube->cp * 2187 + cube->co);
+}
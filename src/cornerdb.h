@@ -0,0 +1,22 @@
+#ifndef __CORNERDB_H
+#define __CORNERDB_H
+
+#include "coordinates.h"
+#include "prune.h"
+
+/*
+ * Corner pattern database.
+ *
+ * The combined corner coordinate (CP x CO, see compute_corner_coord()) has
+ * 88,179,840 values, few enough to store the exact number of moves needed to
+ * solve the corners of every cube. No position needs more than 11 moves to
+ * solve its corners, so the table is stored in nibble format (44MB). Unlike
+ * the main table, it knows exactly where every corner is, which makes it the
+ * stronger bound for cubes whose corners are far from solved.
+ */
+
+void corner_table_spec(int metric, PruneSpec *spec);
+void init_corner_table(int flags, int num_threads);
+int lookup_corner_table(CoordCube *cube);
+
+#endif
@@ -1,7 +1,6 @@
 // See cube.h for details on cube representation.
 #include "cube.h"
 #include <stdio.h>
-#include <stdlib.h>
 
 // Check if a cube is solved.
 bool is_solved(Cube *cube) {
@@ -37,41 +36,35 @@ Cube create_solved_cube() {
     return cube;
 }
 
-// Fisher-Yates shuffle
-void shuffle(uint8_t *list, int size) {
-
-    for(int i = size - 1; i > 0; i--) {
-        int j = rand() % (i + 1);
-        int tmp = list[i];
-        list[i] = list[j];
-        list[j] = tmp;
-    }
-
-}
-
-// determine parity of a permutation by counting inversions
+/*
+ * Determine the parity of a permutation of 0..size-1 from its cycles: a
+ * cycle of k elements takes k - 1 swaps.
+ */
 int compute_parity(uint8_t *list, int size) {
-    int inversions = 0;
+    int visited_mask = 0, parity = 0;
     for(int i = 0; i < size; i++) {
-        for(int j = i + 1; j < size; j++) {
-            if(list[i] > list[j]) inversions++;
+        if(visited_mask & (1 << i)) continue;
+        for(int j = i; !(visited_mask & (1 << j)); j = list[j]) {
+            visited_mask |= 1 << j;
+            parity ^= 1;
         }
+        parity ^= 1;
     }
-    return inversions % 2;
+    return parity;
 }
 
-bool validate_cube(Cube *cube) {
+/*
+ * Check that a cube is a legal state: its cubies are permutations with
+ * matching parities and its orientations are in range and sum correctly.
+ * Returns CUBE_VALID or the first problem found.
+ */
+int validate_cube(Cube *cube) {
 
     int seen_mask = 0;
     for(int i = 0; i < 8; i++) {
         int cubie = cube->corners[i];
-        if(cubie > 7) {
-            printf("illegal corner %d in position %d\n", cubie, i);
-            return false;
-        }
-        if(seen_mask & (1 << cubie)) {
-            printf("corner %d occurs more than once (last seen at %d)\n", cubie, i);
-            return false;
+        if(cubie > 7 || (seen_mask & (1 << cubie))) {
+            return CUBE_ERROR_CORNERS;
         }
         seen_mask |= 1 << cubie;
     }
@@ -79,13 +72,8 @@ bool validate_cube(Cube *cube) {
     seen_mask = 0;
     for(int i = 0; i < 12; i++) {
         int cubie = cube->edges[i];
-        if(cubie > 11) {
-            printf("illegal edge %d in position %d\n", cubie, i);
-            return false;
-        }
-        if(seen_mask & (1 << cubie)) {
-            printf("edge %d occurs more than once (last seen at %d)\n", cubie, i);
-            return false;
+        if(cubie > 11 || (seen_mask & (1 << cubie))) {
+            return CUBE_ERROR_EDGES;
         }
         seen_mask |= 1 << cubie;
     }
@@ -93,35 +81,56 @@ bool validate_cube(Cube *cube) {
     int total_eo = 0;
     for(int i = 0; i < 12; i++) {
         if(cube->edge_orientations[i] > 1) {
-            printf("illegal orientation %d for edge cubie %d\n", cube->edge_orientations[i], i);
-            return false;
+            return CUBE_ERROR_EDGE_ORIENTATION;
         }
         total_eo += cube->edge_orientations[i];
     }
 
     if(total_eo % 2 != 0) {
-        printf("corner orientation not divisible by 3 (%d)\n", total_eo);
-        return false;
+        return CUBE_ERROR_FLIPPED_EDGE;
     }
 
     int total_co = 0;
     for(int i = 0; i < 8; i++) {
         if(cube->corner_orientations[i] > 2) {
-            printf("illegal orientation %d for corner cubie %d\n", cube->corner_orientations[i], i);
-            return false;
+            return CUBE_ERROR_CORNER_ORIENTATION;
         }
         total_co += cube->corner_orientations[i];
     }
 
     if(total_co % 3 != 0) {
-        printf("corner orientation not divisible by 3 (%d)\n", total_co);
-        return false;
+        return CUBE_ERROR_TWISTED_CORNER;
     }
 
-    return true;
+    if(compute_parity(cube->corners, 8) != compute_parity(cube->edges, 12)) {
+        return CUBE_ERROR_PARITY;
+    }
+
+    return CUBE_VALID;
 
 }
 
+const char *cube_error_string(int error) {
+    switch(error) {
+        case CUBE_VALID: return "valid cube";
+        case CUBE_ERROR_LENGTH: return "facelet string isn't 54 characters long";
+        case CUBE_ERROR_COLOR: return "facelet isn't one of W Y O R B G";
+        case CUBE_ERROR_CENTER: return "centers aren't in the standard orientation (white up, green front)";
+        case CUBE_ERROR_CORNER_COLORS: return "no corner has the colors at a corner position";
+        case CUBE_ERROR_EDGE_COLORS: return "no edge has the colors at an edge position";
+        case CUBE_ERROR_CORNERS: return "a corner is missing or appears twice";
+        case CUBE_ERROR_EDGES: return "an edge is missing or appears twice";
+        case CUBE_ERROR_CORNER_ORIENTATION: return "illegal corner orientation";
+        case CUBE_ERROR_EDGE_ORIENTATION: return "illegal edge orientation";
+        case CUBE_ERROR_TWISTED_CORNER: return "corner orientations don't sum to a multiple of 3";
+        case CUBE_ERROR_FLIPPED_EDGE: return "edge orientations don't sum to a multiple of 2";
+        case CUBE_ERROR_PARITY: return "corner and edge permutation parities differ";
+        case CUBE_ERROR_FACE: return "expected a cube face (U D L R B F)";
+        case CUBE_ERROR_DEGREE: return "expected a turn degree (' or 2) or a space after a face";
+        default: return "unknown error";
+    }
+}
+
 void print_cube_raw(Cube *cube) {
 
     printf("corners: ");
@@ -137,56 +146,6 @@ void print_cube_raw(Cube *cube) {
 
 }
 
-// create solvable cube
-Cube create_random_cube() {
-    
-    Cube cube;
-
-    for(int i = 0; i < 8; i++) {
-        cube.corners[i] = i;
-    }
-
-    for(int i = 0; i < 12; i++) {
-        cube.edges[i] = i;
-    }
-
-    shuffle(cube.corners, 8);
-    shuffle(cube.edges, 12);
-
-    // CONSTRAINT: corner permutation parity must match edge permutation parity
-    if(compute_parity(cube.corners, 8) != compute_parity(cube.edges, 12)) {
-
-        // change parity of edges by doing a swap
-        int tmp = cube.edges[0];
-        cube.edges[0] = cube.edges[1];
-        cube.edges[1] = tmp;
-
-    }
-
-    // CONSTRAINT: total edge orientation must be even
-    int total_eo = 0;
-    for(int i = 0; i < 11; i++) {
-        int eo = rand() & 1;
-        total_eo += eo;
-        cube.edge_orientations[i] = eo;
-    }
-
-    cube.edge_orientations[11] = total_eo % 2;
-
-    // CONSTRAINT: total corner orientations must be divisible by three
-    int total_co = 0;
-    for(int i = 0; i < 7; i++) {
-        int co = rand() % 3;
-        total_co += co;
-        cube.corner_orientations[i] = co;    
-    }
-
-    cube.corner_orientations[7] = (3 - total_co % 3) % 3;
-
-    return cube;
-
-}
-
 // Convert face color to ANSI escape code
 const char *get_escape(char color) {
     switch(color) {
@@ -200,37 +159,27 @@ const char *get_escape(char color) {
     }
 }
 
-// Color the facelets for a corner cubie
-void color_corner(char colors[], int corner_pos, char color1, char color2, char color3) {
-    switch(corner_pos) {
-        case ULB: colors[12] = color1; colors[11] = color2; colors[6]  = color3; break;
-        case ULF: colors[36] = color1; colors[45] = color2; colors[35] = color3; break;
-        case URB: colors[14] = color1; colors[8]  = color2; colors[15] = color3; break;
-        case URF: colors[38] = color1; colors[39] = color2; colors[47] = color3; break;
-        case DLB: colors[20] = color1; colors[0]  = color2; colors[9]  = color3; break;
-        case DLF: colors[44] = color1; colors[33] = color2; colors[51] = color3; break;
-        case DRB: colors[18] = color1; colors[17] = color2; colors[2]  = color3; break;
-        case DRF: colors[42] = color1; colors[53] = color2; colors[41] = color3; break;
-    }
-}
+/*
+ * Indices into the array filled by get_cube_colors() of the facelets of each
+ * corner and edge position, and the colors of each cubie, both listed in the
+ * order they appear when the cubie has an orientation of 0. 
+ */
+const int corner_facelets[8][3] = {
+    {12, 11, 6}, {36, 45, 35}, {14, 8, 15}, {38, 39, 47},
+    {20, 0, 9}, {44, 33, 51}, {18, 17, 2}, {42, 53, 41}
+};
 
-// Color the facelets for an edge cubie
-void color_edge(char colors[], int edge_pos, char color1, char color2) {
-    switch(edge_pos) {
-        case UL: colors[24] = color1; colors[23] = color2; break;
-        case UR: colors[26] = color1; colors[27] = color2; break;
-        case UB: colors[13] = color1; colors[7]  = color2; break;
-        case UF: colors[37] = color1; colors[46] = color2; break;
-        case DL: colors[32] = color1; colors[21] = color2; break;
-        case DR: colors[30] = color1; colors[29] = color2; break;
-        case DB: colors[19] = color1; colors[1]  = color2; break;
-        case DF: colors[43] = color1; colors[52] = color2; break;
-        case FL: colors[48] = color1; colors[34] = color2; break;
-        case FR: colors[50] = color1; colors[40] = color2; break;
-        case BL: colors[3] = color1; colors[10]  = color2; break;
-        case BR: colors[5] = color1; colors[16]  = color2; break;
-    }
-}
+const int edge_facelets[12][2] = {
+    {24, 23}, {26, 27}, {13, 7}, {37, 46}, {32, 21}, {30, 29},
+    {19, 1}, {43, 52}, {48, 34}, {50, 40}, {3, 10}, {5, 16}
+};
+
+const char *corner_colors[8] = {"WOB", "WGO", "WBR", "WRG", "YBO", "YOG", "YRB", "YGR"};
+const char *edge_colors[12] = {"WO", "WR", "WB", "WG", "YO", "YR", "YB", "YG", "GO", "GR", "BO", "BR"};
+
+// the facelets which never move, and their colors
+const int center_facelets[6] = {4, 25, 49, 22, 28, 31};
+const char center_colors[6] = {'B', 'W', 'G', 'O', 'R', 'Y'};
 
 void print_row(char colors[], int start_idx, int end_idx, bool terminal) {
     for(int i = start_idx; i < end_idx; i++) {
@@ -269,72 +218,160 @@ void print_row(char colors[], int start_idx, int end_idx, bool terminal) {
 void get_cube_colors(Cube *cube, char *colors) {
 
     // The centers on each face never move, so we can set those easily.
-    colors[4]  = 'B';
-    colors[25] = 'W';
-    colors[49] = 'G';
-    colors[22] = 'O';
-    colors[28] = 'R';
-    colors[31] = 'Y';
+    for(int i = 0; i < 6; i++) {
+        colors[center_facelets[i]] = center_colors[i];
+    }
 
+    /*
+     * We use the WCA scrambling start position as the orientation for our
+     * cube, so white is on top and green is in front. Twisting a corner
+     * clockwise shifts its colors one facelet along.
+     */
     for(int corner_pos = 0; corner_pos < 8; corner_pos++) {
-
         int cubie = cube->corners[corner_pos];
+        int orientation = cube->corner_orientations[cubie];
+        for(int i = 0; i < 3; i++) {
+            colors[corner_facelets[corner_pos][i]] = corner_colors[cubie][(i + 3 - orientation) % 3];
+        }
+    }
 
-        /*
-         * Figure out the colors of the cubie.  We use the WCA scrambling start
-         * position as the orientation for our cube, so white is on top and 
-         * green is in front.
-         */
-        char color1 = '?', color2 = '?', color3 = '?';
-        switch(cubie) {
-            case ULB: color1 = 'W'; color2 = 'O'; color3 = 'B'; break;
-            case ULF: color1 = 'W'; color2 = 'G'; color3 = 'O'; break;
-            case URB: color1 = 'W'; color2 = 'B'; color3 = 'R'; break;
-            case URF: color1 = 'W'; color2 = 'R'; color3 = 'G'; break;
-            case DLB: color1 = 'Y'; color2 = 'B'; color3 = 'O'; break;
-            case DLF: color1 = 'Y'; color2 = 'O'; color3 = 'G'; break;
-            case DRB: color1 = 'Y'; color2 = 'R'; color3 = 'B'; break;
-            case DRF: color1 = 'Y'; color2 = 'G'; color3 = 'R'; break;
+    for(int edge_pos = 0; edge_pos < 12; edge_pos++) {
+        int edge = cube->edges[edge_pos];
+        int orientation = cube->edge_orientations[edge];
+        for(int i = 0; i < 2; i++) {
+            colors[edge_facelets[edge_pos][i]] = edge_colors[edge][i ^ orientation];
         }
+    }
 
-        // Shift colors based on the piece's orientation
-        int orientation = cube->corner_orientations[cubie];
-        if(orientation == 0)
-            color_corner(colors, corner_pos, color1, color2, color3);
-        else if(orientation == 1)
-            color_corner(colors, corner_pos, color3, color1, color2);
-        else
-            color_corner(colors, corner_pos, color2, color3, color1);
+}
 
+/*
+ * Colors numbered so that opposite colors differ only in the lowest bit, with
+ * the D, R and F colors odd: W Y O R B G. Every other character maps to -1.
+ */
+int color_index(char color) {
+    switch(color) {
+        case 'W': return 0;
+        case 'Y': return 1;
+        case 'O': return 2;
+        case 'R': return 3;
+        case 'B': return 4;
+        case 'G': return 5;
+        default: return -1;
     }
+}
 
-    for(int edge_pos = 0; edge_pos < 12; edge_pos++) {
-        
-        int edge = cube->edges[edge_pos];
+// edge cubie with a white or yellow facelet, by the index of its other color
+const int8_t ud_edge_cubies[6] = {-1, -1, UL, UR, UB, UF};
+
+/*
+ * Set a cube from an array of 54 face colors in the format produced by
+ * get_cube_colors(), without allocating or printing. Returns CUBE_VALID or
+ * an error code if the colors don't describe a legal cube, in which case
+ * `cube` may have been partly overwritten.
+ *
+ * This needs to be fast enough to read millions of cubes a second, so rather
+ * than trying every cubie in every position, each cubie is identified from
+ * the axes of its colors and then checked against the colors it should have.
+ */
+int set_cube_colors(Cube *cube, const char *colors) {
 
-        char color1 = '?', color2 = '?';
-        switch(edge) {
-            case UL: color1 = 'W'; color2 = 'O'; break;
-            case UR: color1 = 'W'; color2 = 'R'; break;
-            case UB: color1 = 'W'; color2 = 'B'; break;
-            case UF: color1 = 'W'; color2 = 'G'; break;
-            case DL: color1 = 'Y'; color2 = 'O'; break;
-            case DR: color1 = 'Y'; color2 = 'R'; break;
-            case DB: color1 = 'Y'; color2 = 'B'; break;
-            case DF: color1 = 'Y'; color2 = 'G'; break;
-            case FL: color1 = 'G'; color2 = 'O'; break;
-            case FR: color1 = 'G'; color2 = 'R'; break;
-            case BL: color1 = 'B'; color2 = 'O'; break;
-            case BR: color1 = 'B'; color2 = 'R'; break;
+    int indices[54];
+    for(int i = 0; i < 54; i++) {
+        indices[i] = color_index(colors[i]);
+        if(indices[i] < 0) {
+            return CUBE_ERROR_COLOR;
         }
+    }
 
-        if(cube->edge_orientations[edge] == 0)
-            color_edge(colors, edge_pos, color1, color2);
-        else    
-            color_edge(colors, edge_pos, color2, color1);
+    for(int i = 0; i < 6; i++) {
+        if(colors[center_facelets[i]] != center_colors[i]) {
+            return CUBE_ERROR_CENTER;
+        }
+    }
 
-    } 
+    /*
+     * A corner's white or yellow facelet gives its orientation, and each of
+     * its three colors gives one bit of its cubie: D, R and F.
+     */
+    for(int corner_pos = 0; corner_pos < 8; corner_pos++) {
+        const int *facelets = corner_facelets[corner_pos];
+        int axes = 0, cubie = 0, orientation = 0;
+        for(int i = 0; i < 3; i++) {
+            int color = indices[facelets[i]];
+            int axis = color >> 1;
+            axes |= 1 << axis;
+            cubie |= (color & 1) << (2 - axis);
+            if(axis == 0) {
+                orientation = i;
+            }
+        }
+        const char *c = corner_colors[cubie];
+        if(axes != 7 ||
+           colors[facelets[0]] != c[(3 - orientation) % 3] ||
+           colors[facelets[1]] != c[(4 - orientation) % 3] ||
+           colors[facelets[2]] != c[(5 - orientation) % 3]) {
+            return CUBE_ERROR_CORNER_COLORS;
+        }
+        cube->corners[corner_pos] = cubie;
+        cube->corner_orientations[cubie] = orientation;
+    }
 
+    /*
+     * U and D edges are identified by their other color. The rest are FL, FR,
+     * BL and BR, identified by their R and B bits.
+     */
+    for(int edge_pos = 0; edge_pos < 12; edge_pos++) {
+        const int *facelets = edge_facelets[edge_pos];
+        int a = indices[facelets[0]], b = indices[facelets[1]];
+        int cubie;
+        if(a >> 1 == 0 || b >> 1 == 0) {
+            int ud = a >> 1 == 0 ? a : b, other = a >> 1 == 0 ? b : a;
+            cubie = ud_edge_cubies[other];
+            if(cubie >= 0 && ud) {
+                cubie += DL - UL;
+            }
+        } else {
+            int lr = a >> 1 == 1 ? a : b, fb = a >> 1 == 1 ? b : a;
+            cubie = FL + (lr & 1) + 2 * (~fb & 1);
+        }
+        if(cubie < 0) {
+            return CUBE_ERROR_EDGE_COLORS;
+        }
+        const char *c = edge_colors[cubie];
+        int orientation = colors[facelets[0]] != c[0];
+        if(colors[facelets[0]] != c[orientation] ||
+           colors[facelets[1]] != c[orientation ^ 1]) {
+            return CUBE_ERROR_EDGE_COLORS;
+        }
+        cube->edges[edge_pos] = cubie;
+        cube->edge_orientations[cubie] = orientation;
+    }
+
+    return validate_cube(cube);
+
+}
+
+/*
+ * Set a cube from a NUL-terminated string of exactly 54 face colors (see
+ * set_cube_colors()).
+ */
+int parse_facelets(Cube *cube, const char *facelets) {
+    for(int i = 0; i < 54; i++) {
+        if(facelets[i] == '\0') {
+            return CUBE_ERROR_LENGTH;
+        }
+    }
+    if(facelets[54] != '\0') {
+        return CUBE_ERROR_LENGTH;
+    }
+    return set_cube_colors(cube, facelets);
+}
+
+// Write a cube as a facelet string into a buffer of FACELET_STRING_SIZE chars.
+void write_facelets(Cube *cube, char *facelets) {
+    get_cube_colors(cube, facelets);
+    facelets[54] = '\0';
 }
 
 /*
@@ -454,15 +491,100 @@ void do_move(Cube *cube, int face, int degree) {
     }
 }
 
-// Apply a space-separated sequence of moves to a cube. 
-void do_moves(Cube *cube, const char *moves) {
+Cube move_cubes[18];
 
-    int  face = -1;
+void init_move_cubes() {
+    for(int move = 0; move < 18; move++) {
+        move_cubes[move] = create_solved_cube();
+        do_move(&move_cubes[move], move / 3, move % 3);
+    }
+}
 
-    while(true) {
-        
-        char cur = *moves;
-        moves++;
+/*
+ * Combine corner orientations when multiplying cubes. Orientations of 3 and
+ * above belong to mirrored cubies, which twist in the opposite direction.
+ */
+int combine_orientations(int a, int b) {
+    if(a < 3 && b < 3) return (a + b) % 3;
+    if(a < 3) return a + b >= 6 ? a + b - 3 : a + b;
+    if(b < 3) return a - b < 3 ? a - b + 3 : a - b;
+    return a - b < 0 ? a - b + 3 : a - b;
+}
+
+/*
+ * Compute a*b, the result of applying a and then b. Recall that cubies are
+ * stored by position but orientations are stored by cubie. `result` may be
+ * the same as `a` or `b`.
+ */
+void cube_multiply(Cube *a, Cube *b, Cube *result) {
+
+    Cube r;
+
+    for(int i = 0; i < 8; i++) {
+        int cubie = a->corners[b->corners[i]];
+        r.corners[i] = cubie;
+        r.corner_orientations[cubie] = combine_orientations(a->corner_orientations[cubie], b->corner_orientations[b->corners[i]]);
+    }
+
+    for(int i = 0; i < 12; i++) {
+        int cubie = a->edges[b->edges[i]];
+        r.edges[i] = cubie;
+        r.edge_orientations[cubie] = a->edge_orientations[cubie] ^ b->edge_orientations[b->edges[i]];
+    }
+
+    *result = r;
+
+}
+
+// Compute the cube which undoes `cube`, so that cube * inverse is solved.
+void cube_inverse(Cube *cube, Cube *result) {
+
+    Cube r;
+
+    for(int i = 0; i < 8; i++) {
+        int cubie = cube->corners[i];
+        int o = cube->corner_orientations[cubie];
+        r.corners[cubie] = i;
+        r.corner_orientations[i] = o >= 3 ? o : (3 - o) % 3;
+    }
+
+    for(int i = 0; i < 12; i++) {
+        int cubie = cube->edges[i];
+        r.edges[cubie] = i;
+        r.edge_orientations[i] = cube->edge_orientations[cubie];
+    }
+
+    *result = r;
+
+}
+
+// Compute s*cube*s^-1.
+void cube_conjugate(Cube *cube, Cube *s, Cube *result) {
+    Cube inverse, tmp;
+    cube_inverse(s, &inverse);
+    cube_multiply(s, cube, &tmp);
+    cube_multiply(&tmp, &inverse, result);
+}
+
+// Apply a move (face * 3 + degree) by multiplying with its move cube.
+void cube_move(Cube *cube, int move) {
+    cube_multiply(cube, &move_cubes[move], cube);
+}
+
+/*
+ * Apply a space-separated sequence of moves to a cube. Returns CUBE_VALID, or
+ * CUBE_ERROR_FACE or CUBE_ERROR_DEGREE if the sequence couldn't be parsed, in
+ * which case only the moves before the error have been applied and the
+ * offset of the offending character is stored in `error_offset` (which may be
+ * NULL).
+ */
+int do_moves(Cube *cube, const char *moves, int *error_offset) {
+
+    int face = -1;
+
+    for(int offset = 0; ; offset++) {
+
+        char cur = moves[offset];
 
         if(face != -1) {
             switch(cur) {
@@ -471,8 +593,8 @@ void do_moves(Cube *cube, const char *moves) {
                 case '\0': // <fall through>
                 case ' ': do_move(cube, face, TURN_CW); break;
                 default:
-                    printf("expected turn degree but got '%c'\n", cur);
-                    return;
+                    if(error_offset != NULL) *error_offset = offset;
+                    return CUBE_ERROR_DEGREE;
             }
             face = -1;
         } else {
@@ -486,13 +608,13 @@ void do_moves(Cube *cube, const char *moves) {
                 case ' ': // fall through
                 case '\0': break;
                 default:
-                    printf("expected a cube face but got '%c'\n", cur);
-                    return;
+                    if(error_offset != NULL) *error_offset = offset;
+                    return CUBE_ERROR_FACE;
             }
         }
 
         if(cur == '\0') {
-            return;
+            return CUBE_VALID;
         }
 
     }
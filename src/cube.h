@@ -84,14 +84,65 @@ typedef struct {
     uint8_t edge_orientations[12];
 } Cube;
 
+/*
+ * GROUP OPERATIONS
+ *
+ * A cube state can also be thought of as the sequence of moves that produces
+ * it from the solved state, so two states can be multiplied (apply one, then
+ * the other), and every state has an inverse. Applying a move is the same as
+ * multiplying by the cube for that move, which are precomputed in
+ * `move_cubes` (indexed by face * 3 + degree) by init_move_cubes().
+ *
+ * Multiplication also supports the mirrored corner orientations used to
+ * represent reflections (see symmetry.h).
+ */
+extern Cube move_cubes[18];
+
+/*
+ * FACELET STRINGS
+ *
+ * A cube can also be written as the colors of its 54 facelets, in the order
+ * get_cube_colors() fills them in (see cube.c), using the letters W Y O R B G.
+ * This is the format other programs hand us cubes in, so reading and writing
+ * it doesn't allocate or print: set_cube_colors(), parse_facelets() and
+ * validate_cube() return one of the codes below, which cube_error_string()
+ * describes. So does do_moves() for move sequences, along with where in the
+ * sequence it went wrong.
+ */
+#define FACELET_STRING_SIZE 55 // 54 colors and a terminator
+
+#define CUBE_VALID                    0
+#define CUBE_ERROR_LENGTH             1  // a facelet string isn't 54 characters long
+#define CUBE_ERROR_COLOR              2  // a facelet isn't one of W Y O R B G
+#define CUBE_ERROR_CENTER             3  // a center isn't where the WCA orientation puts it
+#define CUBE_ERROR_CORNER_COLORS      4  // no corner has the colors at a corner position
+#define CUBE_ERROR_EDGE_COLORS        5  // no edge has the colors at an edge position
+#define CUBE_ERROR_CORNERS            6  // a corner is out of range or appears twice
+#define CUBE_ERROR_EDGES              7  // an edge is out of range or appears twice
+#define CUBE_ERROR_CORNER_ORIENTATION 8  // a corner orientation is out of range
+#define CUBE_ERROR_EDGE_ORIENTATION   9  // an edge orientation is out of range
+#define CUBE_ERROR_TWISTED_CORNER     10 // corner orientations don't sum to a multiple of 3
+#define CUBE_ERROR_FLIPPED_EDGE       11 // edge orientations don't sum to a multiple of 2
+#define CUBE_ERROR_PARITY             12 // corner and edge permutation parities differ
+#define CUBE_ERROR_FACE               13 // a move sequence has something other than a face where a move starts
+#define CUBE_ERROR_DEGREE             14 // a face in a move sequence is followed by something other than ' 2 or a space
+
 bool is_solved(Cube *cube);
 Cube create_solved_cube();
-Cube create_random_cube();
-bool validate_cube(Cube *cube);
+int validate_cube(Cube *cube);
+const char *cube_error_string(int error);
 void print_cube_raw(Cube *cube);
 void get_cube_colors(Cube *cube, char *colors);
+int set_cube_colors(Cube *cube, const char *colors);
+int parse_facelets(Cube *cube, const char *facelets);
+void write_facelets(Cube *cube, char *facelets);
 void print_cube(Cube *cube, bool terminal);
 void do_move(Cube *cube, int face, int degree);
-void do_moves(Cube *cube, const char *moves);
+int do_moves(Cube *cube, const char *moves, int *error_offset);
+void init_move_cubes();
+void cube_multiply(Cube *a, Cube *b, Cube *result);
+void cube_inverse(Cube *cube, Cube *result);
+void cube_conjugate(Cube *cube, Cube *s, Cube *result);
+void cube_move(Cube *cube, int move);
 
 #endif
\ No newline at end of file
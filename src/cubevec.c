@@ -0,0 +1,86 @@
+#include "cubevec.h"
+
+CubeVec move_vecs[18];
+
+CubeVec create_solved_vec() {
+    CubeVec vec;
+    for(int i = 0; i < 16; i++) {
+        vec.corners[i] = i;
+        vec.edges[i] = i;
+    }
+    return vec;
+}
+
+CubeVec cube_to_vec(Cube *cube) {
+
+    CubeVec vec = create_solved_vec();
+
+    for(int i = 0; i < 8; i++) {
+        int cubie = cube->corners[i];
+        vec.corners[i] = cubie | cube->corner_orientations[cubie] * VEC_TWIST;
+    }
+
+    for(int i = 0; i < 12; i++) {
+        int cubie = cube->edges[i];
+        vec.edges[i] = cubie | cube->edge_orientations[cubie] * VEC_TWIST;
+    }
+
+    return vec;
+
+}
+
+Cube vec_to_cube(CubeVec *vec) {
+
+    Cube cube;
+
+    for(int i = 0; i < 8; i++) {
+        int cubie = vec->corners[i] & VEC_CUBIE;
+        cube.corners[i] = cubie;
+        cube.corner_orientations[cubie] = vec->corners[i] / VEC_TWIST;
+    }
+
+    for(int i = 0; i < 12; i++) {
+        int cubie = vec->edges[i] & VEC_CUBIE;
+        cube.edges[i] = cubie;
+        cube.edge_orientations[cubie] = vec->edges[i] / VEC_TWIST;
+    }
+
+    return cube;
+
+}
+
+/*
+ * The co, eo and ec coordinates of coordinates.h, read straight off a vector.
+ * Orientations are already stored by position, which is how those coordinates
+ * are defined.
+ */
+int vec_co_coord(const CubeVec *vec) {
+    int coord = 0;
+    for(int i = 6; i >= 0; i--) {
+        coord = coord * 3 + vec->corners[i] / VEC_TWIST;
+    }
+    return coord;
+}
+
+int vec_eo_coord(const CubeVec *vec) {
+    int coord = 0;
+    for(int i = 0; i < 11; i++) {
+        coord |= (vec->edges[i] / VEC_TWIST) << i;
+    }
+    return coord;
+}
+
+int vec_ec_coord(const CubeVec *vec) {
+    int corner_pos = 0, edge_pos = 0;
+    while((vec->corners[corner_pos] & VEC_CUBIE) != 0) corner_pos++;
+    while((vec->edges[edge_pos] & VEC_CUBIE) != 0) edge_pos++;
+    return corner_pos * 12 + edge_pos;
+}
+
+void init_cube_vecs() {
+    for(int move = 0; move < 18; move++) {
+        Cube cube = create_solved_cube();
+        do_move(&cube, move / 3, move % 3);
+        move_vecs[move] = cube_to_vec(&cube);
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef __CUBEVEC_H
+#define __CUBEVEC_H
+
+#include <stdint.h>
+#include <string.h>
+#include "cube.h"
+
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+
+/*
+ * A second representation of the cube, for when we need to apply a lot of
+ * moves to cubie-level cubes (building tables, replaying solutions).
+ *
+ * The corners and edges are each packed into a 16-byte vector. Unlike Cube,
+ * orientations are stored by position: byte i holds the cubie in position i
+ * in its low nibble and that cubie's orientation in bits 4 and 5. The unused
+ * bytes hold their own index, so that every byte of a cube is a valid index
+ * into another cube.
+ *
+ * Multiplying a*b (applying a and then b) then amounts to picking byte
+ * b[i] & 0xf of a for every position i and adding the orientations of both.
+ * The first step is exactly what the SSSE3 pshufb instruction does, which
+ * ignores bits 4 to 6 of the index, so a whole vector is done in a couple of
+ * instructions. Applying a move is just multiplying by the cube for that
+ * move. Without SSSE3 we fall back to doing the same a byte at a time.
+ *
+ * Only real cube states are supported; the mirrored orientations used by
+ * symmetry.c need the slower cube_multiply().
+ */
+
+typedef struct {
+    uint8_t corners[16] __attribute__((aligned(16)));
+    uint8_t edges[16] __attribute__((aligned(16)));
+} CubeVec;
+
+#define VEC_CUBIE  0x0f
+#define VEC_TWIST  0x10  // one twist (corners) or flip (edges)
+#define VEC_ORIENT 0x30
+
+extern CubeVec move_vecs[18];
+
+void init_cube_vecs();
+CubeVec create_solved_vec();
+CubeVec cube_to_vec(Cube *cube);
+Cube vec_to_cube(CubeVec *vec);
+int vec_co_coord(const CubeVec *vec);
+int vec_eo_coord(const CubeVec *vec);
+int vec_ec_coord(const CubeVec *vec);
+
+static inline void vec_multiply(const CubeVec *a, const CubeVec *b, CubeVec *result) {
+
+#ifdef __SSSE3__
+
+    __m128i ac = _mm_load_si128((const __m128i *)a->corners),
+            ae = _mm_load_si128((const __m128i *)a->edges),
+            bc = _mm_load_si128((const __m128i *)b->corners),
+            be = _mm_load_si128((const __m128i *)b->edges);
+
+    // orientations add mod 3: subtract 3 wherever that doesn't wrap around
+    __m128i corners = _mm_add_epi8(_mm_shuffle_epi8(ac, bc), _mm_and_si128(bc, _mm_set1_epi8(VEC_ORIENT)));
+    corners = _mm_min_epu8(corners, _mm_sub_epi8(corners, _mm_set1_epi8(3 * VEC_TWIST)));
+
+    __m128i edges = _mm_xor_si128(_mm_shuffle_epi8(ae, be), _mm_and_si128(be, _mm_set1_epi8(VEC_TWIST)));
+
+    _mm_store_si128((__m128i *)result->corners, corners);
+    _mm_store_si128((__m128i *)result->edges, edges);
+
+#else
+
+    /*
+     * The unused bytes come out holding their own index again, as they do
+     * with pshufb, but they still have to be written: `result` needn't be
+     * one of the operands.
+     */
+    uint8_t corners[16], edges[16];
+
+    for(int i = 0; i < 16; i++) {
+        int corner = a->corners[b->corners[i] & VEC_CUBIE] + (b->corners[i] & VEC_ORIENT);
+        corners[i] = corner >= 3 * VEC_TWIST ? corner - 3 * VEC_TWIST : corner;
+        edges[i] = a->edges[b->edges[i] & VEC_CUBIE] ^ (b->edges[i] & VEC_TWIST);
+    }
+
+    memcpy(result->corners, corners, 16);
+    memcpy(result->edges, edges, 16);
+
+#endif
+
+}
+
+static inline void vec_move(CubeVec *cube, int move) {
+    vec_multiply(cube, &move_vecs[move], cube);
+}
+
+#endif
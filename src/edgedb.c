@@ -0,0 +1,172 @@
+#include "edgedb.h"
+#include "prune.h"
+#include <stdio.h>
+
+const uint8_t edge_subsets[NUM_EDGE_SUBSETS][EDGE_SUBSET_EDGES] = {
+    {UL, UR, UB, UF, DL, DR, DB},
+    {DR, DB, DF, FL, FR, BL, BR}
+};
+
+const char *edge_table_paths[NUM_EDGE_SUBSETS] = {"edges0.prune", "edges1.prune"};
+const char *edge_table_layouts[NUM_EDGE_SUBSETS] = {"pos+ori of UL UR UB UF DL DR DB", "pos+ori of DR DB DF FL FR BL BR"};
+
+PruneTable edge_tables[NUM_EDGE_SUBSETS];
+
+// edge_moves[move][pos * 2 + ori] is where an edge at `pos` with orientation `ori` goes
+uint8_t edge_moves[18][24];
+
+// positions of the four tracked edges for each value of the 12P4 edge coordinate
+uint8_t edge4_positions[11880][4];
+
+
+void init_edge_moves() {
+
+    for(int move = 0; move < 18; move++) {
+        Cube *m = &move_cubes[move];
+        for(int pos = 0; pos < 12; pos++) {
+            int from = m->edges[pos];
+            for(int ori = 0; ori < 2; ori++) {
+                edge_moves[move][from * 2 + ori] = pos * 2 + (ori ^ m->edge_orientations[from]);
+            }
+        }
+    }
+
+    for(int coord = 0; coord < 11880; coord++) {
+        Cube cube = create_solved_cube();
+        set_eslice_coord(&cube, coord);
+        for(int pos = 0; pos < 12; pos++) {
+            if(cube.edges[pos] >= FL) {
+                edge4_positions[coord][cube.edges[pos] - FL] = pos;
+            }
+        }
+    }
+
+}
+
+/*
+ * `slots` holds pos * 2 + ori for each edge of the subset. The positions are
+ * ranked as a partial permutation (the number of unused positions before
+ * each one, in a mixed radix), followed by one bit of orientation per edge.
+ */
+uint64_t rank_edge_subset(const uint8_t *slots) {
+
+    uint64_t rank = 0;
+    int used = 0, orientations = 0;
+
+    for(int i = 0; i < EDGE_SUBSET_EDGES; i++) {
+        int pos = slots[i] >> 1;
+        rank = rank * (12 - i) + __builtin_popcount(~used & ((1 << pos) - 1));
+        used |= 1 << pos;
+        orientations |= (slots[i] & 1) << i;
+    }
+
+    return (rank << EDGE_SUBSET_EDGES) | orientations;
+
+}
+
+void unrank_edge_subset(uint64_t index, uint8_t *slots) {
+
+    int orientations = index & ((1 << EDGE_SUBSET_EDGES) - 1);
+    uint64_t rank = index >> EDGE_SUBSET_EDGES;
+
+    int digits[EDGE_SUBSET_EDGES];
+    for(int i = EDGE_SUBSET_EDGES - 1; i >= 0; i--) {
+        digits[i] = rank % (12 - i);
+        rank /= 12 - i;
+    }
+
+    int used = 0;
+    for(int i = 0; i < EDGE_SUBSET_EDGES; i++) {
+        // find the digits[i]th unused position
+        int pos = 0;
+        for(int skip = digits[i]; skip > 0 || (used & (1 << pos)); pos++) {
+            if(!(used & (1 << pos))) skip--;
+        }
+        used |= 1 << pos;
+        slots[i] = pos * 2 + ((orientations >> i) & 1);
+    }
+
+}
+
+void edge_table_neighbours(uint64_t index, const int *moves, int num_moves, uint64_t *out) {
+
+    uint8_t slots[EDGE_SUBSET_EDGES], next[EDGE_SUBSET_EDGES];
+    unrank_edge_subset(index, slots);
+
+    for(int i = 0; i < num_moves; i++) {
+        for(int j = 0; j < EDGE_SUBSET_EDGES; j++) {
+            next[j] = edge_moves[moves[i]][slots[j]];
+        }
+        out[i] = rank_edge_subset(next);
+    }
+
+}
+
+/*
+ * How to generate the table for one subset in `metric`, without checkpoints.
+ * init_edge_moves() must have been called first.
+ */
+void edge_table_spec(int subset, int metric, PruneSpec *spec) {
+
+    uint8_t solved[EDGE_SUBSET_EDGES];
+    for(int i = 0; i < EDGE_SUBSET_EDGES; i++) {
+        solved[i] = edge_subsets[subset][i] * 2;
+    }
+
+    const int *moves;
+    int num_moves = metric_moves(metric, &moves);
+    *spec = (PruneSpec){EDGE_SUBSET_SIZE, rank_edge_subset(solved), moves, num_moves, edge_table_neighbours, NULL, edge_table_layouts[subset]};
+
+}
+
+void init_edge_tables(int flags, int num_threads) {
+
+    init_edge_moves();
+
+    for(int subset = 0; subset < NUM_EDGE_SUBSETS; subset++) {
+
+        const char *path = edge_table_paths[subset], *layout = edge_table_layouts[subset];
+        fprintf(stderr, "loading pruning table %s...\n", path);
+
+        int result = load_prune_table(&edge_tables[subset], path, layout, EDGE_SUBSET_SIZE, PRUNE_NIBBLE, flags);
+        if(result == PRUNE_OK) {
+            continue;
+        }
+
+        fprintf(stderr, "couldn't load pruning table %s: %s\n", path, prune_error_string(result));
+        fprintf(stderr, "building edge pattern database %d...\n", subset);
+
+        PruneSpec spec;
+        edge_table_spec(subset, METRIC_HTM, &spec);
+        spec.path = path;
+
+        alloc_prune_table(&edge_tables[subset], EDGE_SUBSET_SIZE, PRUNE_NIBBLE);
+        generate_prune_table(&spec, &edge_tables[subset], num_threads);
+        save_prune_table(&edge_tables[subset], path, layout);
+
+    }
+
+}
+
+// Exact number of moves needed to solve one subset of the edges of a cube.
+int lookup_edge_table(CoordCube *cube, int subset) {
+
+    const uint8_t *groups[3] = {
+        edge4_positions[cube->u_edges],
+        edge4_positions[cube->d_edges],
+        edge4_positions[cube->e_edges]
+    };
+
+    // the orientation of the edge in position 11 is implied by the others
+    int eo = cube->eo | (__builtin_parity(cube->eo) << 11);
+
+    uint8_t slots[EDGE_SUBSET_EDGES];
+    for(int i = 0; i < EDGE_SUBSET_EDGES; i++) {
+        int edge = edge_subsets[subset][i];
+        int pos = groups[edge >> 2][edge & 3];
+        slots[i] = pos * 2 + ((eo >> pos) & 1);
+    }
+
+    return prune_get(&edge_tables[subset], rank_edge_subset(slots));
+
+}
@@ -0,0 +1,35 @@
+#ifndef __EDGEDB_H
+#define __EDGEDB_H
+
+#include "coordinates.h"
+#include "prune.h"
+
+/*
+ * Edge pattern databases.
+ *
+ * Following Korf, we complement the corner pattern database with databases
+ * for subsets of the edges, each storing the exact number of moves needed to
+ * solve the position and orientation of the edges in the subset. A subset of
+ * 7 edges has 12P7 * 2^7 = 510,935,040 states, stored in nibble format
+ * (255MB per table).
+ *
+ * Twelve edges can't be split into two disjoint sets of 7, so our two subsets
+ * (UL UR UB UF DL DR DB and DR DB DF FL FR BL BR) share two edges. That's fine
+ * since we only ever take the maximum of the tables' values, never the sum.
+ *
+ * There is no move table for these coordinates; instead each edge's position
+ * and orientation is moved with a 24-entry table and the subset re-ranked.
+ * During the search, the positions of the edges are recovered from the
+ * U, D and E-slice edge coordinates.
+ */
+
+#define EDGE_SUBSET_EDGES 7
+#define EDGE_SUBSET_SIZE  510935040 // 12P7 * 2^7
+#define NUM_EDGE_SUBSETS  2
+
+void init_edge_moves();
+void edge_table_spec(int subset, int metric, PruneSpec *spec);
+void init_edge_tables(int flags, int num_threads);
+int lookup_edge_table(CoordCube *cube, int subset);
+
+#endif
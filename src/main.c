@@ -1,52 +1,182 @@
 #include "search.h"
+#include "twophase.h"
+#include "batch.h"
+#include "parallel.h"
+#include "prune.h"
 #include "coordinates.h"
 #include "cube.h"
+#include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
-void print_solution(int *solution) {
-    for(int i = 0; i < 32; i++) {
-        if(solution[i] != 0xff) {
-            int degree = solution[i] % 3, face = solution[i] / 3;
-            switch(face) {
-                case 0: putchar('U'); break;
-                case 1: putchar('D'); break;
-                case 2: putchar('L'); break;
-                case 3: putchar('R'); break;
-                case 4: putchar('B'); break;
-                case 5: putchar('F'); break;
-            }
-            switch(degree) {
-                case 1: putchar('\''); break;
-                case 2: putchar('2');
-            }
-            putchar(' ');
-        }
+void print_solution(int *solution, int length) {
+    for(int i = 0; i < length; i++) {
+        printf("%s ", move_to_string(solution[i]));
     }
 }
 
+void print_usage(const char *name) {
+    fprintf(stderr, "usage: %s [-h] [-2] [-j threads] [-f format] [-BqceEisvpH] [-l max_length] [-n max_nodes] [-t time_limit_ms] <scramble | facelets | -b file>\n", name);
+    fprintf(stderr, "  facelets are the 54 colors of a cube as printed without a terminal, row by row (see cube.h)\n");
+    fprintf(stderr, "  -h  print this help and exit\n");
+    fprintf(stderr, "  -2  use the two-phase solver instead of optimal IDA*\n");
+    fprintf(stderr, "  -b  solve every cube in a file (- for stdin), one per line (see batch.h); each output line is\n");
+    fprintf(stderr, "      line number, length (-1 if unsolved), milliseconds, nodes, proven lower bound, solution,\n");
+    fprintf(stderr, "      separated by tabs, with - for the nodes and bound of two-phase solves\n");
+    fprintf(stderr, "  -B  (with -b) read and write binary state files instead of text (see statefile.h)\n");
+    fprintf(stderr, "  -j  number of threads to search and build tables with (default 1)\n");
+    fprintf(stderr, "  -f  pruning table format: byte, nibble or mod3 (default byte)\n");
+    fprintf(stderr, "  -q  (optimal) find the shortest solution in quarter turns\n");
+    fprintf(stderr, "  -c  also prune with the corner pattern database\n");
+    fprintf(stderr, "  -e  also prune with the edge pattern databases\n");
+    fprintf(stderr, "  -E  also prune with the E-slice pattern database\n");
+    fprintf(stderr, "  -i  also probe the pruning table with the inverse and rotated cube\n");
+    fprintf(stderr, "  -s  also prune with the symmetry-reduced flip-slice table\n");
+    fprintf(stderr, "  -v  verify the pruning table checksum when loading it\n");
+    fprintf(stderr, "  -p  read the whole pruning table into memory up front\n");
+    fprintf(stderr, "  -H  ask for the pruning table to be backed by huge pages\n");
+    fprintf(stderr, "  -l  (two-phase) stop once a solution this short is found (default 21)\n");
+    fprintf(stderr, "  -n  (optimal) give up after searching this many nodes (default no limit)\n");
+    fprintf(stderr, "  -t  stop searching after this many milliseconds (default 1000 for two-phase, no limit for optimal)\n");
+}
+
 int main(int argc, char **argv) {
 
-    printf("initializing coordinate multiplication tables...\n");
+    bool two_phase = false, state_files = false, symmetry = false, corners = false, edges = false, slice = false, probes = false;
+    const char *batch_path = NULL;
+    uint64_t max_nodes = 0;
+    int max_length = 21, time_limit_ms = -1, num_threads = 1, format = PRUNE_BYTE, metric = METRIC_HTM, load_flags = 0;
+
+    int opt;
+    while((opt = getopt(argc, argv, "2b:Bj:f:qceEisvpHl:n:t:h")) != -1) {
+        switch(opt) {
+            case '2': two_phase = true; break;
+            case 'b': batch_path = optarg; break;
+            case 'B': state_files = true; break;
+            case 'j': num_threads = atoi(optarg); break;
+            case 'f': format = parse_prune_format(optarg); break;
+            case 'q': metric = METRIC_QTM; break;
+            case 'c': corners = true; break;
+            case 'e': edges = true; break;
+            case 'E': slice = true; break;
+            case 'i': probes = true; break;
+            case 's': symmetry = true; break;
+            case 'v': load_flags |= PRUNE_LOAD_VERIFY; break;
+            case 'p': load_flags |= PRUNE_LOAD_POPULATE; break;
+            case 'H': load_flags |= PRUNE_LOAD_HUGEPAGES; break;
+            case 'l': max_length = atoi(optarg); break;
+            case 'n': max_nodes = strtoull(optarg, NULL, 10); break;
+            case 't': time_limit_ms = atoi(optarg); break;
+            case 'h':
+                print_usage(argv[0]);
+                return 0;
+            default:
+                print_usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if((optind >= argc && batch_path == NULL) || num_threads < 1 || format < 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if(time_limit_ms < 0) {
+        time_limit_ms = two_phase ? 1000 : 0;
+    }
+
+    fprintf(stderr, "initializing coordinate multiplication tables...\n");
     init_mult_tables();
 
-    printf("initializing pruning tables...\n");
-    init_pruning_table();
+    if(two_phase) {
+        fprintf(stderr, "initializing two-phase pruning tables...\n");
+        init_two_phase_tables();
+    } else {
+        fprintf(stderr, "initializing pruning tables...\n");
+        init_pruning_table(format, metric, load_flags, num_threads);
+        if(corners) {
+            init_corner_pruning(load_flags, num_threads);
+        }
+        if(slice) {
+            init_slice_pruning(load_flags, num_threads);
+        }
+        if(edges) {
+            init_edge_pruning(load_flags, num_threads);
+        }
+        if(symmetry) {
+            init_symmetry_pruning(load_flags, num_threads);
+        }
+        if(probes) {
+            init_extra_probes();
+        }
+    }
 
+    if(batch_path != NULL) {
+
+        FILE *in = strcmp(batch_path, "-") == 0 ? stdin : fopen(batch_path, state_files ? "rb" : "r");
+        if(in == NULL) {
+            perror("failed to open batch file");
+            return 1;
+        }
+
+        BatchOptions options = {two_phase, max_length, time_limit_ms, max_nodes, num_threads, state_files};
+        solve_batch(in, stdout, &options);
+
+        if(in != stdin) {
+            fclose(in);
+        }
+        return 0;
+
+    }
+
+    // like batch lines, a 54-character argument without spaces is a facelet string
     Cube cube = create_solved_cube();
-    do_moves(&cube, argv[1]);
+    const char *input = argv[optind];
+    if(strlen(input) == 54 && strchr(input, ' ') == NULL) {
+        int error = parse_facelets(&cube, input);
+        if(error != CUBE_VALID) {
+            fprintf(stderr, "invalid cube: %s\n", cube_error_string(error));
+            return 1;
+        }
+    } else {
+        int offset, error = do_moves(&cube, input, &offset);
+        if(error != CUBE_VALID) {
+            fprintf(stderr, "invalid move sequence at character %d: %s\n", offset + 1, cube_error_string(error));
+            return 1;
+        }
+    }
     print_cube(&cube, true);
     
-    int solution[32];
-    for(int i = 0; i < 32; i++) {
-        solution[i] = 0xff;
+    if(two_phase) {
+        int solution[32];
+        int length = solve_two_phase(&cube, max_length, time_limit_ms, solution);
+        if(length < 0) {
+            printf("no solution found\n");
+            return 1;
+        }
+        print_solution(solution, length);
+        printf("(%d moves)\n", length);
+        return 0;
     }
 
-    for(int depth = 0; depth < 21; depth++) {
-        printf("searching depth %d\n", depth);
-        if(search(&cube, -1, 0, depth, solution)) {
-            print_solution(solution);
-            break;
-        }
+    CoordCube coords = compute_coord_cube(&cube);
+    SearchBudget budget = {max_nodes, time_limit_ms};
+    OptimalResult result;
+    bool optimal = solve_optimal(&coords, &budget, num_threads, &result);
+    const char *unit = metric == METRIC_QTM ? "quarter turns" : "moves";
+
+    if(optimal) {
+        print_solution(result.solution, result.length);
+        printf("(%d %s, optimal)\n", result.length, unit);
+    } else if(result.lower_bound > metric_diameter(metric)) {
+        printf("cube is unsolvable\n");
+    } else {
+        printf("no solution found within the budget; an optimal solution has at least %d %s\n", result.lower_bound, unit);
     }
 
-}
\ No newline at end of file
+    printf("searched %llu nodes in %.3fs\n", (unsigned long long)result.stats.nodes, result.ms / 1e3);
+    return optimal ? 0 : 1;
+
+}
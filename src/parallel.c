@@ -0,0 +1,287 @@
+#include "parallel.h"
+#include "search.h"
+#include "coordinates.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// how many subtrees we aim to create per thread
+#define TASKS_PER_THREAD 32
+
+// how deep we are willing to expand the tree before handing it out
+#define MAX_SPLIT_DEPTH 8
+
+typedef struct {
+    SearchNode node;
+    int distance;
+    int depth;
+    int moves[MAX_SPLIT_DEPTH];
+} SearchTask;
+
+/*
+ * Owners take tasks from the bottom of their own queue, thieves take them
+ * from the top. Tasks are large enough that a mutex per queue costs nothing
+ * noticeable.
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    SearchTask *tasks;
+    int top;
+    int bottom;
+} TaskQueue;
+
+typedef struct {
+    TaskQueue *queues;
+    int num_threads;
+    int max_depth;
+    uint64_t node_limit;  // per thread
+    double deadline_ms;
+    atomic_bool stop;     // set once a solution is found or a budget runs out
+    pthread_mutex_t solution_lock;
+    bool found;           // protected by solution_lock, like the rest
+    bool out_of_budget;
+    int *solution;
+    SearchStats stats;
+} WorkerPool;
+
+typedef struct {
+    WorkerPool *pool;
+    int id;
+} Worker;
+
+bool pop_task(TaskQueue *queue, SearchTask *task) {
+    bool success = false;
+    pthread_mutex_lock(&queue->lock);
+    if(queue->bottom > queue->top) {
+        *task = queue->tasks[--queue->bottom];
+        success = true;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return success;
+}
+
+bool steal_task(TaskQueue *queue, SearchTask *task) {
+    bool success = false;
+    pthread_mutex_lock(&queue->lock);
+    if(queue->bottom > queue->top) {
+        *task = queue->tasks[queue->top++];
+        success = true;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return success;
+}
+
+bool take_task(WorkerPool *pool, int id, SearchTask *task) {
+
+    if(pop_task(&pool->queues[id], task)) {
+        return true;
+    }
+
+    // no work left for us, so go looking for someone else's
+    for(int i = 1; i < pool->num_threads; i++) {
+        if(steal_task(&pool->queues[(id + i) % pool->num_threads], task)) {
+            return true;
+        }
+    }
+
+    return false;
+
+}
+
+void *search_worker(void *arg) {
+
+    Worker *worker = arg;
+    WorkerPool *pool = worker->pool;
+
+    int solution[32];
+    SearchContext ctx = {solution, &pool->stop, {0, 0}, pool->node_limit, pool->deadline_ms};
+
+    SearchTask task;
+    while(!atomic_load(&pool->stop) && take_task(pool, worker->id, &task)) {
+        memcpy(solution, task.moves, task.depth * sizeof(int));
+        if(search(&ctx, &task.node, task.distance, task.depth, pool->max_depth)) {
+            pthread_mutex_lock(&pool->solution_lock);
+            if(!pool->found) {
+                memcpy(pool->solution, solution, pool->max_depth * sizeof(int));
+                pool->found = true;
+                atomic_store(&pool->stop, true);
+            }
+            pthread_mutex_unlock(&pool->solution_lock);
+        }
+        if(ctx.out_of_budget) {
+            // the other threads can't finish the iteration without us, so stop them too
+            pthread_mutex_lock(&pool->solution_lock);
+            pool->out_of_budget = true;
+            atomic_store(&pool->stop, true);
+            pthread_mutex_unlock(&pool->solution_lock);
+        }
+    }
+
+    pthread_mutex_lock(&pool->solution_lock);
+    pool->stats.nodes += ctx.stats.nodes;
+    pool->stats.lookups += ctx.stats.lookups;
+    pthread_mutex_unlock(&pool->solution_lock);
+
+    return NULL;
+
+}
+
+/*
+ * Expand the frontier by one level, applying the same move ordering and
+ * pruning rules as search(). Returns true if one of the children is solved,
+ * in which case its moves are written to `solution`.
+ */
+bool expand_frontier(SearchTask *frontier, int size, SearchTask **next_frontier, int *next_size, int max_depth, int *solution, SearchStats *stats) {
+
+    const int *moves;
+    int num_moves = search_move_set(&moves);
+
+    SearchTask *next = malloc(size * num_moves * sizeof(SearchTask));
+    int count = 0;
+
+    for(int i = 0; i < size; i++) {
+
+        SearchTask *task = &frontier[i];
+        stats->nodes++;
+        for(int m = 0; m < num_moves; m++) {
+
+            int move = moves[m];
+            if(!is_canonical_move(task->moves, task->depth, move))
+                continue;
+
+            SearchTask child;
+            CoordCube *cube = &child.node.cube;
+            mult_coord_cube(&task->node.cube, move, cube);
+            mult_extra_probes(&task->node, move, &child.node);
+            child.distance = lookup_child_distance(cube, task->distance);
+            stats->lookups++;
+            if(task->depth + child.distance >= max_depth ||
+               task->depth + lookup_extra_probes(&child.node, max_depth - task->depth, stats) >= max_depth ||
+               task->depth + lookup_secondary_tables(cube, max_depth - task->depth, stats) >= max_depth)
+                continue;
+
+            memcpy(child.moves, task->moves, task->depth * sizeof(int));
+            child.moves[task->depth] = move;
+            child.depth = task->depth + 1;
+
+            if(is_coord_cube_solved(cube)) {
+                memcpy(solution, child.moves, child.depth * sizeof(int));
+                free(next);
+                return true;
+            }
+
+            next[count++] = child;
+
+        }
+
+    }
+
+    *next_frontier = next;
+    *next_size = count;
+    return false;
+
+}
+
+/*
+ * Search for a solution of exactly `max_depth` moves (shorter solutions are
+ * assumed to have been ruled out already) using `num_threads` threads. The
+ * solution goes to `ctx->solution` and the work done by all threads is added
+ * to `ctx->stats`. The node and time limits of `ctx` are honoured, with the
+ * remaining nodes split evenly between the threads.
+ */
+bool parallel_search(SearchContext *ctx, CoordCube *cube, int max_depth, int num_threads) {
+
+    SearchTask *frontier = malloc(sizeof(SearchTask));
+    init_search_node(&frontier[0].node, cube);
+    frontier[0].distance = lookup_pruning_table(cube);
+    frontier[0].depth = 0;
+    int size = 1;
+
+    while(size < num_threads * TASKS_PER_THREAD && frontier[0].depth < max_depth - 1 && frontier[0].depth < MAX_SPLIT_DEPTH) {
+
+        SearchTask *next;
+        int next_size;
+        bool solved = expand_frontier(frontier, size, &next, &next_size, max_depth, ctx->solution, &ctx->stats);
+        free(frontier);
+
+        if(solved || next_size == 0) {
+            if(!solved) {
+                free(next);
+            }
+            return solved;
+        }
+
+        frontier = next;
+        size = next_size;
+
+    }
+
+    if(ctx->node_limit != 0 && ctx->stats.nodes >= ctx->node_limit) {
+        free(frontier);
+        ctx->out_of_budget = true;
+        return false;
+    }
+
+    WorkerPool pool;
+    pool.num_threads = num_threads;
+    pool.max_depth = max_depth;
+    pool.node_limit = ctx->node_limit != 0 ? (ctx->node_limit - ctx->stats.nodes + num_threads - 1) / num_threads : 0;
+    pool.deadline_ms = ctx->deadline_ms;
+    pool.solution = ctx->solution;
+    pool.stats = (SearchStats){0, 0};
+    pool.found = false;
+    pool.out_of_budget = false;
+    atomic_init(&pool.stop, false);
+    pthread_mutex_init(&pool.solution_lock, NULL);
+
+    // deal out tasks round-robin, since neighbouring subtrees tend to be similar in size
+    pool.queues = malloc(num_threads * sizeof(TaskQueue));
+    for(int i = 0; i < num_threads; i++) {
+        TaskQueue *queue = &pool.queues[i];
+        pthread_mutex_init(&queue->lock, NULL);
+        queue->tasks = malloc((size / num_threads + 1) * sizeof(SearchTask));
+        queue->top = 0;
+        queue->bottom = 0;
+    }
+
+    for(int i = 0; i < size; i++) {
+        TaskQueue *queue = &pool.queues[i % num_threads];
+        queue->tasks[queue->bottom++] = frontier[i];
+    }
+
+    free(frontier);
+
+    pthread_t *threads = malloc(num_threads * sizeof(pthread_t));
+    Worker *workers = malloc(num_threads * sizeof(Worker));
+    for(int i = 0; i < num_threads; i++) {
+        workers[i].pool = &pool;
+        workers[i].id = i;
+        if(pthread_create(&threads[i], NULL, search_worker, &workers[i]) != 0) {
+            perror("failed to create search thread");
+            exit(1);
+        }
+    }
+
+    for(int i = 0; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    for(int i = 0; i < num_threads; i++) {
+        pthread_mutex_destroy(&pool.queues[i].lock);
+        free(pool.queues[i].tasks);
+    }
+
+    free(pool.queues);
+    free(threads);
+    free(workers);
+    pthread_mutex_destroy(&pool.solution_lock);
+
+    ctx->stats.nodes += pool.stats.nodes;
+    ctx->stats.lookups += pool.stats.lookups;
+    ctx->out_of_budget = pool.out_of_budget && !pool.found;
+    return pool.found;
+
+}
@@ -0,0 +1,22 @@
+#ifndef __PARALLEL_H
+#define __PARALLEL_H
+
+#include <stdbool.h>
+#include "coordinates.h"
+#include "search.h"
+
+/*
+ * Each iteration of IDA* is a depth-first search, which parallelizes nicely:
+ * the subtrees below different move sequences are independent, and the only
+ * shared state is the pruning table, which is read-only once built.
+ *
+ * We expand the top levels of the tree breadth-first until there are enough
+ * subtrees to keep every thread busy, then hand them out round-robin to
+ * per-thread work queues. Subtrees vary wildly in size, so a thread that
+ * runs out of work steals from the other end of another thread's queue. As
+ * soon as any thread finds a solution, the others abandon their subtrees.
+ */
+
+bool parallel_search(SearchContext *ctx, CoordCube *cube, int max_depth, int num_threads);
+
+#endif
@@ -0,0 +1,657 @@
+#include "prune.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// entries handed to a generator thread at a time; a multiple of 4 so threads never share a byte
+#define GENERATE_CHUNK 65536
+
+uint64_t prune_table_bytes(uint64_t size, int format) {
+    switch(format) {
+        case PRUNE_NIBBLE: return (size + 1) / 2;
+        case PRUNE_MOD3: return (size + 3) / 4;
+        default: return size;
+    }
+}
+
+/*
+ * Anonymous memory for a table, on 2MB boundaries so that it can be backed
+ * by huge pages: a random lookup into a table of hundreds of megabytes
+ * misses the TLB almost every time with 4KB pages. We take explicit huge
+ * pages if any have been reserved, and otherwise ask for transparent ones.
+ */
+#define HUGE_PAGE_BYTES (2 << 20)
+
+uint8_t *alloc_table_memory(uint64_t bytes, uint64_t *mapping_bytes) {
+
+    *mapping_bytes = (bytes + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES;
+
+    uint8_t *memory = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    memory = mmap(NULL, *mapping_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+    if(memory == MAP_FAILED) {
+        memory = mmap(NULL, *mapping_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(memory == MAP_FAILED) {
+            perror("failed to allocate pruning table");
+            exit(1);
+        }
+#ifdef MADV_HUGEPAGE
+        madvise(memory, *mapping_bytes, MADV_HUGEPAGE);
+#endif
+    }
+
+    return memory;
+
+}
+
+void alloc_prune_table(PruneTable *table, uint64_t size, int format) {
+    table->size = size;
+    table->format = format;
+    table->data = alloc_table_memory(prune_table_bytes(size, format), &table->mapping_bytes);
+    table->mapping = table->data;
+}
+
+void free_prune_table(PruneTable *table) {
+    munmap(table->mapping, table->mapping_bytes);
+    table->mapping = NULL;
+    table->data = NULL;
+}
+
+/*
+ * Repack a generated table (in byte or nibble format) into another format.
+ * Unreached entries stay unreached, which PRUNE_MOD3 has no way to say, so
+ * the source must be fully reached to pack it that way.
+ */
+void convert_prune_table(PruneTable *src, PruneTable *dst, int format) {
+
+    int src_unreached = src->format == PRUNE_NIBBLE ? 0xf : 0xff;
+    int dst_unreached = format == PRUNE_NIBBLE ? 0xf : 0xff;
+
+    alloc_prune_table(dst, src->size, format);
+    memset(dst->data, 0, prune_table_bytes(dst->size, format));
+
+    for(uint64_t i = 0; i < src->size; i++) {
+        int value = prune_get(src, i);
+        if(value == src_unreached) {
+            if(format == PRUNE_MOD3) {
+                fprintf(stderr, "can't store unreached entry %llu in a mod3 table\n", (unsigned long long)i);
+                exit(1);
+            }
+            value = dst_unreached;
+        } else if(value >= dst_unreached) {
+            fprintf(stderr, "distance %d of entry %llu doesn't fit in a %s table\n", value, (unsigned long long)i, prune_format_name(format));
+            exit(1);
+        }
+        prune_set(dst, i, value);
+    }
+
+}
+
+const char *prune_format_name(int format) {
+    switch(format) {
+        case PRUNE_NIBBLE: return "nibble";
+        case PRUNE_MOD3: return "mod3";
+        default: return "byte";
+    }
+}
+
+int parse_prune_format(const char *name) {
+    if(strcmp(name, "byte") == 0) return PRUNE_BYTE;
+    if(strcmp(name, "nibble") == 0) return PRUNE_NIBBLE;
+    if(strcmp(name, "mod3") == 0) return PRUNE_MOD3;
+    return -1;
+}
+
+// 64-bit FNV-1a, applied to whole words so that checking a large table is cheap.
+uint64_t prune_checksum(const uint8_t *data, uint64_t bytes) {
+
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    uint64_t words = bytes / 8;
+
+    for(uint64_t i = 0; i < words; i++) {
+        uint64_t word;
+        memcpy(&word, data + i * 8, 8);
+        hash = (hash ^ word) * 0x100000001b3ULL;
+    }
+
+    for(uint64_t i = words * 8; i < bytes; i++) {
+        hash = (hash ^ data[i]) * 0x100000001b3ULL;
+    }
+
+    return hash;
+
+}
+
+const char *prune_error_string(int error) {
+    switch(error) {
+        case PRUNE_OK: return "ok";
+        case PRUNE_ERR_MISSING: return "file does not exist";
+        case PRUNE_ERR_IO: return "I/O error";
+        case PRUNE_ERR_TRUNCATED: return "file is truncated";
+        case PRUNE_ERR_MAGIC: return "not a pruning table file";
+        case PRUNE_ERR_VERSION: return "unsupported file version";
+        case PRUNE_ERR_FORMAT: return "table has a different format";
+        case PRUNE_ERR_LAYOUT: return "table has a different coordinate layout";
+        case PRUNE_ERR_SIZE: return "table has a different size";
+        case PRUNE_ERR_CHECKSUM: return "checksum mismatch";
+        default: return "unknown error";
+    }
+}
+
+/*
+ * Read just the header of a table file, for looking at tables without knowing
+ * what's in them ahead of time. Only the magic and version are checked.
+ */
+int read_prune_header(const char *path, PruneFileHeader *header) {
+
+    FILE *fp = fopen(path, "rb");
+    if(fp == NULL) {
+        return errno == ENOENT ? PRUNE_ERR_MISSING : PRUNE_ERR_IO;
+    }
+
+    size_t read = fread(header, sizeof(*header), 1, fp);
+    int failed = ferror(fp);
+    fclose(fp);
+
+    if(read != 1) {
+        return failed ? PRUNE_ERR_IO : PRUNE_ERR_TRUNCATED;
+    }
+    if(memcmp(header->magic, PRUNE_MAGIC, 8) != 0) {
+        return PRUNE_ERR_MAGIC;
+    }
+    if(header->version != PRUNE_VERSION) {
+        return PRUNE_ERR_VERSION;
+    }
+    return PRUNE_OK;
+
+}
+
+/*
+ * Map a table file, checking that it matches the table we expect. On success
+ * `table` points into the mapping; otherwise `table` is left untouched.
+ */
+int load_prune_table(PruneTable *table, const char *path, const char *layout, uint64_t size, int format, int flags) {
+
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) {
+        return errno == ENOENT ? PRUNE_ERR_MISSING : PRUNE_ERR_IO;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) < 0) {
+        close(fd);
+        return PRUNE_ERR_IO;
+    }
+
+    if((uint64_t)st.st_size < PRUNE_HEADER_BYTES) {
+        close(fd);
+        return PRUNE_ERR_TRUNCATED;
+    }
+
+    int mmap_flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    if(flags & PRUNE_LOAD_POPULATE) mmap_flags |= MAP_POPULATE;
+#endif
+
+    uint8_t *mapping = mmap(NULL, st.st_size, PROT_READ, mmap_flags, fd, 0);
+    close(fd);
+    if(mapping == MAP_FAILED) {
+        return PRUNE_ERR_IO;
+    }
+
+    PruneFileHeader header;
+    memcpy(&header, mapping, sizeof(header));
+
+    uint64_t bytes = prune_table_bytes(size, format);
+    int result = PRUNE_OK;
+    if(memcmp(header.magic, PRUNE_MAGIC, 8) != 0) result = PRUNE_ERR_MAGIC;
+    else if(header.version != PRUNE_VERSION) result = PRUNE_ERR_VERSION;
+    else if(header.format != (uint32_t)format) result = PRUNE_ERR_FORMAT;
+    else if(strncmp(header.layout, layout, sizeof(header.layout)) != 0) result = PRUNE_ERR_LAYOUT;
+    else if(header.size != size) result = PRUNE_ERR_SIZE;
+    else if((uint64_t)st.st_size < PRUNE_HEADER_BYTES + bytes) result = PRUNE_ERR_TRUNCATED;
+    else if((flags & PRUNE_LOAD_VERIFY) && prune_checksum(mapping + PRUNE_HEADER_BYTES, bytes) != header.checksum) result = PRUNE_ERR_CHECKSUM;
+
+    if(result != PRUNE_OK) {
+        munmap(mapping, st.st_size);
+        return result;
+    }
+
+    table->size = size;
+    table->format = format;
+
+    /*
+     * The page cache can't give us huge pages for a file, so to get them we
+     * copy the table into anonymous memory and drop the file mapping.
+     */
+    if(flags & PRUNE_LOAD_HUGEPAGES) {
+        table->data = alloc_table_memory(bytes, &table->mapping_bytes);
+        table->mapping = table->data;
+        memcpy(table->data, mapping + PRUNE_HEADER_BYTES, bytes);
+        munmap(mapping, st.st_size);
+        return PRUNE_OK;
+    }
+
+    // Lookups are scattered all over the table, so readahead only wastes I/O.
+    madvise(mapping, st.st_size, (flags & PRUNE_LOAD_POPULATE) ? MADV_WILLNEED : MADV_RANDOM);
+
+    table->data = mapping + PRUNE_HEADER_BYTES;
+    table->mapping = mapping;
+    table->mapping_bytes = st.st_size;
+    return PRUNE_OK;
+
+}
+
+/*
+ * Write a header page followed by a table's entries. The file is written
+ * under a temporary name and only renamed into place once it's safely on
+ * disk, so nobody (including a process resuming from a checkpoint) ever sees
+ * a partly written file.
+ */
+void write_table_file(const char *path, const void *header, size_t header_bytes, const uint8_t *data, uint64_t bytes) {
+
+    uint8_t header_page[PRUNE_HEADER_BYTES] = {0};
+    memcpy(header_page, header, header_bytes);
+
+    char tmp_path[4096];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    FILE *fp = fopen(tmp_path, "wb");
+    if(fp == NULL) {
+        perror("failed to open pruning table for writing");
+        exit(1);
+    }
+
+    if(fwrite(header_page, 1, PRUNE_HEADER_BYTES, fp) != PRUNE_HEADER_BYTES ||
+       fwrite(data, 1, bytes, fp) != bytes ||
+       fflush(fp) != 0 || fsync(fileno(fp)) != 0) {
+        perror("failed to write pruning table");
+        fclose(fp);
+        exit(1);
+    }
+
+    if(fclose(fp) != 0 || rename(tmp_path, path) != 0) {
+        perror("failed to write pruning table");
+        exit(1);
+    }
+
+}
+
+void checkpoint_path(const char *path, char *out, size_t size) {
+    snprintf(out, size, "%s.checkpoint", path);
+}
+
+// Save a finished table, replacing any checkpoint left from generating it.
+void save_prune_table(PruneTable *table, const char *path, const char *layout) {
+
+    uint64_t bytes = prune_table_bytes(table->size, table->format);
+
+    PruneFileHeader header = {0};
+    memcpy(header.magic, PRUNE_MAGIC, 8);
+    header.version = PRUNE_VERSION;
+    header.format = table->format;
+    strncpy(header.layout, layout, sizeof(header.layout) - 1);
+    header.size = table->size;
+    header.checksum = prune_checksum(table->data, bytes);
+
+    write_table_file(path, &header, sizeof(header), table->data, bytes);
+
+    char checkpoint[4096];
+    checkpoint_path(path, checkpoint, sizeof(checkpoint));
+    unlink(checkpoint);
+
+}
+
+void save_checkpoint(PruneSpec *spec, PruneTable *table, int depth, uint64_t reached) {
+
+    uint64_t bytes = prune_table_bytes(table->size, table->format);
+
+    PruneCheckpointHeader header = {0};
+    memcpy(header.table.magic, PRUNE_CHECKPOINT_MAGIC, 8);
+    header.table.version = PRUNE_VERSION;
+    header.table.format = table->format;
+    strncpy(header.table.layout, spec->layout, sizeof(header.table.layout) - 1);
+    header.table.size = table->size;
+    header.table.checksum = prune_checksum(table->data, bytes);
+    header.depth = depth;
+    header.reached = reached;
+
+    char path[4096];
+    checkpoint_path(spec->path, path, sizeof(path));
+    write_table_file(path, &header, sizeof(header), table->data, bytes);
+
+}
+
+/*
+ * Read the checkpoint for a table into `table`, returning false if there's
+ * no usable one. A checkpoint for a different table is ignored, and will be
+ * overwritten by the next one.
+ */
+bool load_checkpoint(PruneSpec *spec, PruneTable *table, int *depth, uint64_t *reached) {
+
+    char path[4096];
+    checkpoint_path(spec->path, path, sizeof(path));
+
+    FILE *fp = fopen(path, "rb");
+    if(fp == NULL) {
+        return false;
+    }
+
+    uint64_t bytes = prune_table_bytes(table->size, table->format);
+    PruneCheckpointHeader header;
+    uint8_t header_page[PRUNE_HEADER_BYTES];
+
+    bool ok = fread(header_page, 1, PRUNE_HEADER_BYTES, fp) == PRUNE_HEADER_BYTES;
+    memcpy(&header, header_page, sizeof(header));
+    ok = ok && memcmp(header.table.magic, PRUNE_CHECKPOINT_MAGIC, 8) == 0 &&
+         header.table.version == PRUNE_VERSION &&
+         header.table.format == (uint32_t)table->format &&
+         strncmp(header.table.layout, spec->layout, sizeof(header.table.layout)) == 0 &&
+         header.table.size == table->size;
+    ok = ok && fread(table->data, 1, bytes, fp) == bytes && prune_checksum(table->data, bytes) == header.table.checksum;
+    fclose(fp);
+
+    if(!ok) {
+        fprintf(stderr, "ignoring unusable checkpoint %s\n", path);
+        return false;
+    }
+
+    *depth = header.depth;
+    *reached = header.reached;
+    return true;
+
+}
+
+/*
+ * Several threads write to the table at once during generation, so entries
+ * are accessed with atomic builtins here. Relaxed loads and stores compile to
+ * ordinary moves.
+ */
+int generator_unvisited(PruneTable *table) {
+    return table->format == PRUNE_NIBBLE ? 0xf : 0xff;
+}
+
+int generator_get(PruneTable *table, uint64_t index) {
+    if(table->format == PRUNE_NIBBLE) {
+        uint8_t byte = __atomic_load_n(&table->data[index >> 1], __ATOMIC_RELAXED);
+        return (byte >> ((index & 1) << 2)) & 0xf;
+    }
+    return __atomic_load_n(&table->data[index], __ATOMIC_RELAXED);
+}
+
+// Set an unvisited entry. Returns false if another thread got there first.
+bool generator_claim(PruneTable *table, uint64_t index, int value) {
+
+    if(table->format != PRUNE_NIBBLE) {
+        uint8_t expected = 0xff;
+        return __atomic_compare_exchange_n(&table->data[index], &expected, value, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    }
+
+    uint8_t *byte = &table->data[index >> 1];
+    int shift = (index & 1) << 2;
+    uint8_t old = __atomic_load_n(byte, __ATOMIC_RELAXED);
+    while(((old >> shift) & 0xf) == 0xf) {
+        uint8_t new = (old & ~(0xf << shift)) | (value << shift);
+        if(__atomic_compare_exchange_n(byte, &old, new, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            return true;
+        }
+    }
+    return false;
+
+}
+
+/*
+ * Claim an entry along with any equivalent entries, returning how many of them
+ * we set.
+ */
+uint64_t generator_claim_all(PruneSpec *spec, PruneTable *table, uint64_t index, int value) {
+
+    uint64_t filled = generator_claim(table, index, value);
+
+    if(spec->equivalents != NULL) {
+        uint64_t equivalents[PRUNE_MAX_EQUIVALENTS];
+        int count = spec->equivalents(index, equivalents);
+        for(int i = 0; i < count; i++) {
+            filled += generator_claim(table, equivalents[i], value);
+        }
+    }
+
+    return filled;
+
+}
+
+typedef struct {
+    PruneSpec *spec;
+    PruneTable *table;
+    int depth;
+    bool backward;
+    atomic_uint_fast64_t next_chunk;
+    atomic_uint_fast64_t filled;
+} GeneratorPass;
+
+void *generator_worker(void *arg) {
+
+    GeneratorPass *pass = arg;
+    PruneSpec *spec = pass->spec;
+    PruneTable *table = pass->table;
+    int unvisited = generator_unvisited(table);
+
+    uint64_t neighbours[32];
+    uint64_t filled = 0;
+
+    while(true) {
+
+        uint64_t start = atomic_fetch_add(&pass->next_chunk, GENERATE_CHUNK);
+        if(start >= spec->size) break;
+        uint64_t end = start + GENERATE_CHUNK < spec->size ? start + GENERATE_CHUNK : spec->size;
+
+        for(uint64_t i = start; i < end; i++) {
+
+            if(pass->backward) {
+
+                /*
+                 * Entries in this chunk belong to us, but their equivalents
+                 * might not, so another thread could claim one of those
+                 * first (with the same value).
+                 */
+                if(generator_get(table, i) != unvisited) continue;
+                spec->neighbours(i, spec->moves, spec->num_moves, neighbours);
+                for(int j = 0; j < spec->num_moves; j++) {
+                    if(generator_get(table, neighbours[j]) == pass->depth) {
+                        filled += generator_claim_all(spec, table, i, pass->depth + 1);
+                        break;
+                    }
+                }
+
+            } else {
+
+                if(generator_get(table, i) != pass->depth) continue;
+                spec->neighbours(i, spec->moves, spec->num_moves, neighbours);
+                for(int j = 0; j < spec->num_moves; j++) {
+                    if(generator_get(table, neighbours[j]) == unvisited) {
+                        filled += generator_claim_all(spec, table, neighbours[j], pass->depth + 1);
+                    }
+                }
+
+            }
+
+        }
+
+    }
+
+    atomic_fetch_add(&pass->filled, filled);
+    return NULL;
+
+}
+
+double seconds_since(struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/*
+ * Fill a table (in byte or nibble format) with the distance of every entry
+ * from the goal, one depth at a time.
+ *
+ * While few entries have been reached, we search forwards: scan the table for
+ * entries at the current depth and mark their unvisited neighbours. Once more
+ * than half the table has been reached, most neighbours have already been
+ * visited, so it's cheaper to search backwards: scan for unvisited entries and
+ * check whether any of their neighbours are at the current depth. Either way
+ * the table is split into chunks which are handed out to `num_threads`
+ * threads.
+ */
+void generate_prune_table(PruneSpec *spec, PruneTable *table, int num_threads) {
+
+    int first_depth = 0;
+    uint64_t reached = 1, filled = 1;
+
+    if(spec->path != NULL && load_checkpoint(spec, table, &first_depth, &reached)) {
+        fprintf(stderr, "resuming from checkpoint at depth %d (%llu entries)\n", first_depth, (unsigned long long)reached);
+    } else {
+        memset(table->data, 0xff, prune_table_bytes(table->size, table->format));
+        reached = generator_claim_all(spec, table, spec->goal, 0);
+    }
+
+    pthread_t *threads = malloc(num_threads * sizeof(pthread_t));
+
+    struct timespec total_start, last_checkpoint;
+    clock_gettime(CLOCK_MONOTONIC, &total_start);
+    last_checkpoint = total_start;
+
+    for(int depth = first_depth; filled > 0; depth++) {
+
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        GeneratorPass pass;
+        pass.spec = spec;
+        pass.table = table;
+        pass.depth = depth;
+        pass.backward = reached > spec->size / 2;
+        atomic_init(&pass.next_chunk, 0);
+        atomic_init(&pass.filled, 0);
+
+        for(int i = 0; i < num_threads; i++) {
+            if(pthread_create(&threads[i], NULL, generator_worker, &pass) != 0) {
+                perror("failed to create generator thread");
+                exit(1);
+            }
+        }
+
+        for(int i = 0; i < num_threads; i++) {
+            pthread_join(threads[i], NULL);
+        }
+
+        filled = atomic_load(&pass.filled);
+        reached += filled;
+        fprintf(stderr, "depth %2d: %12llu entries (%s, %.2fs)\n", depth + 1, (unsigned long long)filled,
+               pass.backward ? "backward" : "forward", seconds_since(&start));
+
+        // cheap depths aren't worth writing the whole table out for
+        if(spec->path != NULL && filled > 0 && seconds_since(&last_checkpoint) >= PRUNE_CHECKPOINT_SECONDS) {
+            save_checkpoint(spec, table, depth + 1, reached);
+            clock_gettime(CLOCK_MONOTONIC, &last_checkpoint);
+            fprintf(stderr, "checkpointed depth %d\n", depth + 1);
+        }
+
+    }
+
+    fprintf(stderr, "generated %llu entries in %.2fs\n", (unsigned long long)reached, seconds_since(&total_start));
+    free(threads);
+
+}
+
+typedef struct {
+    PruneTable *table;
+    atomic_uint_fast64_t next_chunk;
+    pthread_mutex_t lock;
+    PruneDistribution *dist;
+} DistributionPass;
+
+void *distribution_worker(void *arg) {
+
+    DistributionPass *pass = arg;
+    PruneTable *table = pass->table;
+
+    // counted privately and merged at the end, so threads don't fight over the counters
+    uint64_t counts[256] = {0};
+
+    while(true) {
+
+        uint64_t start = atomic_fetch_add(&pass->next_chunk, GENERATE_CHUNK);
+        if(start >= table->size) break;
+        uint64_t end = start + GENERATE_CHUNK < table->size ? start + GENERATE_CHUNK : table->size;
+
+        // chunks hold a whole number of bytes in every format, so bytes can be counted directly
+        if(table->format == PRUNE_BYTE) {
+            for(uint64_t i = start; i < end; i++) {
+                counts[table->data[i]]++;
+            }
+        } else if(table->format == PRUNE_NIBBLE && end - start == GENERATE_CHUNK) {
+            for(uint64_t i = start >> 1; i < end >> 1; i++) {
+                counts[table->data[i] & 0xf]++;
+                counts[table->data[i] >> 4]++;
+            }
+        } else {
+            for(uint64_t i = start; i < end; i++) {
+                counts[prune_get(table, i)]++;
+            }
+        }
+
+    }
+
+    pthread_mutex_lock(&pass->lock);
+    for(int i = 0; i < 256; i++) {
+        pass->dist->counts[i] += counts[i];
+    }
+    pthread_mutex_unlock(&pass->lock);
+
+    return NULL;
+
+}
+
+// Count the entries holding each value, splitting the table between `num_threads` threads.
+void prune_distribution(PruneTable *table, PruneDistribution *dist, int num_threads) {
+
+    memset(dist, 0, sizeof(*dist));
+
+    DistributionPass pass;
+    pass.table = table;
+    pass.dist = dist;
+    atomic_init(&pass.next_chunk, 0);
+    pthread_mutex_init(&pass.lock, NULL);
+
+    pthread_t *threads = malloc(num_threads * sizeof(pthread_t));
+    for(int i = 0; i < num_threads; i++) {
+        if(pthread_create(&threads[i], NULL, distribution_worker, &pass) != 0) {
+            perror("failed to create distribution thread");
+            exit(1);
+        }
+    }
+
+    for(int i = 0; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    free(threads);
+    pthread_mutex_destroy(&pass.lock);
+
+    for(int i = 0; i < 256; i++) {
+        if(dist->counts[i] > 0) {
+            dist->max_value = i;
+        }
+    }
+
+}
@@ -0,0 +1,186 @@
+#ifndef __PRUNE_H
+#define __PRUNE_H
+
+#include <stdint.h>
+
+/*
+ * Pruning table storage formats.
+ *
+ * Distances in the pruning tables we use never exceed 15, so storing one byte
+ * per entry wastes half of the table. PRUNE_NIBBLE packs two entries into
+ * each byte, with 0xf marking entries that haven't been reached yet.
+ *
+ * PRUNE_MOD3 goes further and only stores the distance modulo 3, packing four
+ * entries into each byte. This is enough to recover exact distances during a
+ * search: a single move changes the distance by at most one, so if we know
+ * the exact distance of a node, the distance of each child is one of d - 1,
+ * d and d + 1, which all differ mod 3. The exact distance of the root can be
+ * found by repeatedly stepping to the neighbour whose value is one less (mod
+ * 3) until we arrive at the solved state.
+ */
+
+#define PRUNE_BYTE   0
+#define PRUNE_NIBBLE 1
+#define PRUNE_MOD3   2
+
+/*
+ * Pruning table files.
+ *
+ * Table files start with a header describing the table, padded to a page so
+ * that the entries themselves are page-aligned. Files are memory-mapped read-
+ * only rather than read into private memory, so processes using the same
+ * table share one copy in the page cache and don't need to wait for the whole
+ * file to be read before starting. Every field in the header is checked on
+ * load; the checksum (which requires reading the whole table) is only
+ * checked if PRUNE_LOAD_VERIFY is given.
+ */
+
+#define PRUNE_MAGIC        "CUBEPRUN"
+#define PRUNE_VERSION      1
+#define PRUNE_HEADER_BYTES 4096
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t format;
+    char layout[48];  // describes the coordinates making up the index
+    uint64_t size;    // number of entries
+    uint64_t checksum;
+} PruneFileHeader;
+
+/*
+ * Generation checkpoints.
+ *
+ * Big tables take a long time to generate, so while a table that will be
+ * saved at `path` is being generated, the entries are periodically written
+ * to `path`.checkpoint along with the depth they're complete up to.
+ * Generation resumes from there if it's interrupted, and save_prune_table()
+ * removes the checkpoint once the finished table is in place.
+ */
+#define PRUNE_CHECKPOINT_MAGIC   "CUBECKPT"
+#define PRUNE_CHECKPOINT_SECONDS 30  // least time between checkpoints
+
+typedef struct {
+    PruneFileHeader table;  // with PRUNE_CHECKPOINT_MAGIC instead of PRUNE_MAGIC
+    uint32_t depth;         // entries up to this distance are final
+    uint64_t reached;       // entries reached so far
+} PruneCheckpointHeader;
+
+// flags for load_prune_table
+#define PRUNE_LOAD_VERIFY    1  // verify the checksum
+#define PRUNE_LOAD_POPULATE  2  // fault in the whole table up front
+#define PRUNE_LOAD_HUGEPAGES 4  // copy the table into memory backed by huge pages
+
+// results of load_prune_table
+#define PRUNE_OK             0
+#define PRUNE_ERR_MISSING    1
+#define PRUNE_ERR_IO         2
+#define PRUNE_ERR_TRUNCATED  3
+#define PRUNE_ERR_MAGIC      4
+#define PRUNE_ERR_VERSION    5
+#define PRUNE_ERR_FORMAT     6
+#define PRUNE_ERR_LAYOUT     7
+#define PRUNE_ERR_SIZE       8
+#define PRUNE_ERR_CHECKSUM   9
+
+typedef struct {
+    uint8_t *data;
+    uint64_t size;
+    int format;
+    void *mapping;  // the mapping holding the table: the file, or anonymous memory
+    uint64_t mapping_bytes;
+} PruneTable;
+
+/*
+ * Pruning table generation.
+ *
+ * A table is described by its size, the index of the solved state and a
+ * function which computes the neighbours of an entry under a set of moves.
+ * The move set must be closed under inverses, since generation also searches
+ * backwards (see generate_prune_table()). If the spec names the file and
+ * layout the table will be saved with, generation is checkpointed.
+ *
+ * Some tables hold several entries for the same state (symmetry-reduced ones,
+ * where a class is fixed by some symmetries), of which the neighbours function
+ * only ever returns one. An equivalents function lists the others for an
+ * entry, so they can be filled in along with it; it returns how many there are
+ * (at most PRUNE_MAX_EQUIVALENTS).
+ */
+#define PRUNE_MAX_EQUIVALENTS 16
+
+typedef void (*PruneNeighbours)(uint64_t index, const int *moves, int num_moves, uint64_t *out);
+typedef int (*PruneEquivalents)(uint64_t index, uint64_t *out);
+
+typedef struct {
+    uint64_t size;
+    uint64_t goal;
+    const int *moves;
+    int num_moves;
+    PruneNeighbours neighbours;
+    const char *path;    // NULL to generate without checkpoints
+    const char *layout;
+    PruneEquivalents equivalents;  // NULL if every state has one entry
+} PruneSpec;
+
+/*
+ * How many entries of a table hold each value. Unreached entries are counted
+ * under 0xf (nibble) or 0xff (byte). For PRUNE_MOD3 tables the values are
+ * distances mod 3, which say little about the distances themselves.
+ */
+typedef struct {
+    uint64_t counts[256];
+    int max_value;  // the largest value held by any entry
+} PruneDistribution;
+
+uint64_t prune_table_bytes(uint64_t size, int format);
+void alloc_prune_table(PruneTable *table, uint64_t size, int format);
+void free_prune_table(PruneTable *table);
+void convert_prune_table(PruneTable *src, PruneTable *dst, int format);
+const char *prune_format_name(int format);
+int parse_prune_format(const char *name);
+uint64_t prune_checksum(const uint8_t *data, uint64_t bytes);
+int read_prune_header(const char *path, PruneFileHeader *header);
+int load_prune_table(PruneTable *table, const char *path, const char *layout, uint64_t size, int format, int flags);
+void save_prune_table(PruneTable *table, const char *path, const char *layout);
+const char *prune_error_string(int error);
+void generate_prune_table(PruneSpec *spec, PruneTable *table, int num_threads);
+void prune_distribution(PruneTable *table, PruneDistribution *dist, int num_threads);
+
+// Read the raw value stored for an entry (the distance mod 3 for PRUNE_MOD3).
+static inline int prune_get(PruneTable *table, uint64_t index) {
+    switch(table->format) {
+        case PRUNE_NIBBLE: return (table->data[index >> 1] >> ((index & 1) << 2)) & 0xf;
+        case PRUNE_MOD3: return (table->data[index >> 2] >> ((index & 3) << 1)) & 3;
+        default: return table->data[index];
+    }
+}
+
+// Start fetching the byte holding an entry into the cache.
+static inline void prune_prefetch(PruneTable *table, uint64_t index) {
+    uint64_t byte = table->format == PRUNE_NIBBLE ? index >> 1 : table->format == PRUNE_MOD3 ? index >> 2 : index;
+    __builtin_prefetch(&table->data[byte]);
+}
+
+static inline void prune_set(PruneTable *table, uint64_t index, int value) {
+    switch(table->format) {
+        case PRUNE_NIBBLE: {
+            int shift = (index & 1) << 2;
+            table->data[index >> 1] = (table->data[index >> 1] & ~(0xf << shift)) | ((value & 0xf) << shift);
+            break;
+        }
+        case PRUNE_MOD3: {
+            int shift = (index & 3) << 1;
+            table->data[index >> 2] = (table->data[index >> 2] & ~(3 << shift)) | ((value % 3) << shift);
+            break;
+        }
+        default: table->data[index] = value;
+    }
+}
+
+// Recover the exact distance of a node from its mod 3 value and its parent's distance.
+static inline int decode_mod3(int value, int parent_distance) {
+    int diff = (value - parent_distance % 3 + 3) % 3;
+    return diff == 2 ? parent_distance - 1 : parent_distance + diff;
+}
+
+#endif
@@ -0,0 +1,118 @@
+#include "random.h"
+#include "statefile.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// cubes generated from each seed by create_random_cubes()
+#define RANDOM_BLOCK 4096
+
+#define CORNER_STATES 88179840ULL      // 8! * 3^7
+#define EDGE_STATES   490497638400ULL  // 12! / 2 * 2^11
+
+uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+void seed_rng(Rng *rng, uint64_t seed) {
+    for(int i = 0; i < 4; i++) {
+        rng->s[i] = splitmix64(&seed);
+    }
+}
+
+/*
+ * A uniform number below `bound`, without the bias of rng_next() % bound.
+ * This is Lemire's method: the high half of a 64x64-bit product is uniform
+ * except for a few low halves, which we reject. That needs a division, but
+ * only when the low half is small enough that rejection is possible at all.
+ */
+uint64_t rng_below(Rng *rng, uint64_t bound) {
+    unsigned __int128 product = (unsigned __int128)rng_next(rng) * bound;
+    uint64_t low = product;
+    if(low < bound) {
+        uint64_t threshold = -bound % bound;
+        while(low < threshold) {
+            product = (unsigned __int128)rng_next(rng) * bound;
+            low = product;
+        }
+    }
+    return product >> 64;
+}
+
+Cube create_random_cube(Rng *rng) {
+
+    uint64_t corners = rng_below(rng, CORNER_STATES);
+    uint64_t edges = rng_below(rng, EDGE_STATES);
+
+    // the rank is corners * EDGE_STATES + edges, which takes 66 bits
+    unsigned __int128 value = (unsigned __int128)corners * EDGE_STATES + edges;
+    CubeRank rank = {(uint64_t)value, (uint64_t)(value >> 64)};
+
+    Cube cube;
+    unrank_cube(rank, &cube);
+    return cube;
+
+}
+
+typedef struct {
+    Cube *cubes;
+    uint64_t count;
+    uint64_t seed;
+    atomic_uint_fast64_t next_block;
+} RandomJob;
+
+void *random_worker(void *arg) {
+
+    RandomJob *job = arg;
+
+    while(true) {
+
+        uint64_t block = atomic_fetch_add(&job->next_block, 1);
+        uint64_t start = block * RANDOM_BLOCK;
+        if(start >= job->count) break;
+        uint64_t end = start + RANDOM_BLOCK < job->count ? start + RANDOM_BLOCK : job->count;
+
+        Rng rng;
+        seed_rng(&rng, job->seed ^ block);
+        for(uint64_t i = start; i < end; i++) {
+            job->cubes[i] = create_random_cube(&rng);
+        }
+
+    }
+
+    return NULL;
+
+}
+
+/*
+ * Fill `cubes` with `count` random states using several threads. The cubes
+ * are generated in blocks, each with a generator seeded from `seed` and the
+ * block number, so the result only depends on the seed and not on how many
+ * threads there are.
+ */
+void create_random_cubes(Cube *cubes, uint64_t count, uint64_t seed, int num_threads) {
+
+    RandomJob job;
+    job.cubes = cubes;
+    job.count = count;
+    job.seed = splitmix64(&seed);
+    atomic_init(&job.next_block, 0);
+
+    pthread_t *threads = malloc(num_threads * sizeof(pthread_t));
+    for(int i = 0; i < num_threads; i++) {
+        if(pthread_create(&threads[i], NULL, random_worker, &job) != 0) {
+            perror("failed to create random cube thread");
+            exit(1);
+        }
+    }
+
+    for(int i = 0; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+
+}
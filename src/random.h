@@ -0,0 +1,48 @@
+#ifndef __RANDOM_H
+#define __RANDOM_H
+
+#include <stdint.h>
+#include "cube.h"
+
+/*
+ * Random cube states.
+ *
+ * Random numbers come from an explicit generator rather than rand(), so each
+ * thread can have its own and sequences can be reproduced from a seed. The
+ * generator is xoshiro256** seeded through splitmix64; everything else only
+ * draws through rng_next(), so swapping in a different generator means
+ * changing Rng and these two functions.
+ *
+ * A random state is drawn by picking its corner and edge halves of a rank
+ * (see statefile.h) uniformly and unranking it, so every legal state is
+ * equally likely and no draws are thrown away for parity or orientation.
+ */
+
+typedef struct {
+    uint64_t s[4];
+} Rng;
+
+void seed_rng(Rng *rng, uint64_t seed);
+
+static inline uint64_t rng_rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t rng_next(Rng *rng) {
+    uint64_t *s = rng->s;
+    uint64_t result = rng_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rng_rotl(s[3], 45);
+    return result;
+}
+
+uint64_t rng_below(Rng *rng, uint64_t bound);
+Cube create_random_cube(Rng *rng);
+void create_random_cubes(Cube *cubes, uint64_t count, uint64_t seed, int num_threads);
+
+#endif
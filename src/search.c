@@ -1,176 +1,619 @@
 #include "search.h"
+#include "prune.h"
 #include "coordinates.h"
+#include "symmetry.h"
+#include "cornerdb.h"
+#include "edgedb.h"
+#include "slicedb.h"
+#include "cubevec.h"
 #include "cube.h"
+#include "parallel.h"
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 
 #define TABLE_SIZE 429981696
 
-uint8_t *table;
+PruneTable table;
+int search_metric = METRIC_HTM;
+const int *search_moves;
+int num_search_moves;
+
+/*
+ * The moves worth trying next, by whether the last move repeated the one
+ * before it and by the last move plus one (0 at the root), so that the
+ * search doesn't have to check every move against the path.
+ */
+int next_moves[2][19][18];
+int num_next_moves[2][19];
+bool use_symmetry_table = false;
+bool use_corner_table = false;
+bool use_edge_tables = false;
+bool use_slice_table = false;
+bool use_extra_probes = false;
+
+// the rotations conjugating the R-L and F-B axes onto U-D, as symmetry indices and as vectors
+int axis_syms[2];
+CubeVec axis_vecs[2];
+CubeVec axis_vec_inverses[2];
+
+void calculate_table_stats(PruneTable *table, int num_threads) {
+
+    PruneDistribution dist;
+    prune_distribution(table, &dist, num_threads);
+
+    uint64_t sum = 0;
+    for(int i = 0; i <= dist.max_value; i++) {
+        fprintf(stderr, "depth %d: %llu (%.2f%%)\n", i, (unsigned long long)dist.counts[i], (double)dist.counts[i] * 100 / TABLE_SIZE);
+        sum += dist.counts[i] * i;
+    }
+
+    fprintf(stderr, "expected value: %.2f\n", (double)sum / TABLE_SIZE);
+
+}
+
+int build_table_index(int co, int eo, int ec) {
+    return ec * 4478976 + eo * 2187 + co;  
+}
+
+// QTM tables are kept next to the HTM ones, under their own names.
+const char *table_path(int format) {
+    static const char *paths[2][3] = {
+        {"corners.prune", "corners.nibble.prune", "corners.mod3.prune"},
+        {"corners.qtm.prune", "corners.qtm.nibble.prune", "corners.qtm.mod3.prune"}
+    };
+    int column = format == PRUNE_NIBBLE ? 1 : format == PRUNE_MOD3 ? 2 : 0;
+    return paths[search_metric == METRIC_QTM][column];
+}
+
+// Describes build_table_index() and the metric, so that tables with a different layout are rejected.
+const char *table_layout(int metric) {
+    return metric == METRIC_QTM ? "co:2187 eo:2048 ec:96 qtm" : "co:2187 eo:2048 ec:96";
+}
+
+/*
+ * Try to map the table file for `format`. Returns false if there is no usable
+ * file, in which case the table has to be generated.
+ */
+bool load_pruning_table(PruneTable *table, int format, int flags) {
+
+    const char *path = table_path(format);
+    fprintf(stderr, "loading pruning table %s...\n", path);
+
+    int result = load_prune_table(table, path, table_layout(search_metric), TABLE_SIZE, format, flags);
+    if(result == PRUNE_OK) {
+        return true;
+    }
+
+    fprintf(stderr, "couldn't load pruning table %s: %s\n", path, prune_error_string(result));
+    return false;
+
+}
 
-void calculate_table_stats() {
+void table_neighbours(uint64_t index, const int *moves, int num_moves, uint64_t *out) {
 
-    int freq[256];
-    for(int i = 0; i < 256; i++) {
-        freq[i] = 0;
+    int ec = index / 4478976,
+        eo = (index % 4478976) / 2187,
+        co = index % 2187;
+
+    for(int i = 0; i < num_moves; i++) {
+        out[i] = build_table_index(mult_co(co, moves[i]), mult_eo(eo, moves[i]), mult_ec(ec, moves[i]));
     }
 
-    int max = 0;
-    unsigned long long sum = 0;
-    for(int i = 0; i < TABLE_SIZE; i++) {
-        freq[table[i]]++;
-        max = table[i] > max ? table[i] : max;
-        sum += table[i];
+}
+
+// How to generate the main table for `metric`, without checkpoints.
+void main_table_spec(int metric, PruneSpec *spec) {
+    const int *moves;
+    int num_moves = metric_moves(metric, &moves);
+    *spec = (PruneSpec){TABLE_SIZE, 0, moves, num_moves, table_neighbours, NULL, table_layout(metric)};
+}
+
+// Generate the table in byte format, since we need exact distances to build it.
+void build_pruning_table(PruneTable *table, int num_threads) {
+
+    fprintf(stderr, "building pruning table (%s)...\n", search_metric == METRIC_QTM ? "QTM" : "HTM");
+
+    PruneSpec spec;
+    main_table_spec(search_metric, &spec);
+    spec.path = table_path(PRUNE_BYTE);
+    generate_prune_table(&spec, table, num_threads);
+
+    save_prune_table(table, table_path(PRUNE_BYTE), table_layout(search_metric));
+    calculate_table_stats(table, num_threads);
+
+}
+
+// The moves the search branches on, in the metric of the pruning table.
+int search_move_set(const int **moves) {
+    *moves = search_moves;
+    return num_search_moves;
+}
+
+/*
+ * Whether `move` is worth trying after the `depth` moves of `path`. Turning
+ * the same face twice in a row is redundant, and so is turning opposite faces
+ * in the wrong order, since they commute. In QTM a half turn is a quarter
+ * turn done twice, so a clockwise quarter turn may be repeated once (but not
+ * twice). Repeating a counter-clockwise one would give the same half turn
+ * again.
+ */
+bool is_canonical_move(const int *path, int depth, int move) {
+
+    if(depth == 0) {
+        return true;
     }
 
-    for(int i = 0; i <= max; i++) {
-        printf("depth %d: %d (%.2f%%)\n", i, freq[i], (double)freq[i] * 100 / TABLE_SIZE);
+    int last = path[depth - 1];
+    if(search_metric == METRIC_QTM && move == last) {
+        return move % 3 == TURN_CW && (depth < 2 || path[depth - 2] != last);
     }
 
-    printf("expected value: %.2f\n", (double)sum / TABLE_SIZE);
+    return !is_redundant(last / 3, move / 3);
 
 }
 
-int build_table_index(int co, int eo, int ec) {
-    return ec * 4478976 + eo * 2187 + co;  
+void init_next_moves() {
+    for(int repeated = 0; repeated < 2; repeated++) {
+        for(int last = -1; last < 18; last++) {
+            int path[2] = {repeated ? last : -1, last}, count = 0;
+            for(int i = 0; i < num_search_moves; i++) {
+                if(last == -1 || is_canonical_move(path, 2, search_moves[i])) {
+                    next_moves[repeated][last + 1][count++] = search_moves[i];
+                }
+            }
+            num_next_moves[repeated][last + 1] = count;
+        }
+    }
 }
 
-void build_pruning_table() {
+/*
+ * Load the pruning table for `metric` in the requested format, and search in
+ * that metric from now on. Packed tables are derived from the byte-format
+ * table, which is loaded or built first if necessary. `flags` are passed on
+ * to load_prune_table(), and generation is split across `num_threads` threads.
+ *
+ * The other tables are always built for HTM. They are still admissible in
+ * QTM, since no cube is fewer quarter turns than face turns from solved.
+ */
+void init_pruning_table(int format, int metric, int flags, int num_threads) {
+
+    search_metric = metric;
+    num_search_moves = metric_moves(metric, &search_moves);
+    init_next_moves();
+
+    if(load_pruning_table(&table, format, flags)) {
+        return;
+    }
 
-    printf("building pruning table...\n");
+    PruneTable bytes;
+    if(format == PRUNE_BYTE || !load_pruning_table(&bytes, PRUNE_BYTE, flags)) {
+        alloc_prune_table(&bytes, TABLE_SIZE, PRUNE_BYTE);
+        build_pruning_table(&bytes, num_threads);
+    }
 
-    for(int i = 0; i < TABLE_SIZE; i++) {
-        table[i] = 0xff;
+    if(format == PRUNE_BYTE) {
+        table = bytes;
+        return;
     }
 
-    table[0] = 0;
+    fprintf(stderr, "packing pruning table (%s)...\n", prune_format_name(format));
+    convert_prune_table(&bytes, &table, format);
+    free_prune_table(&bytes);
+    save_prune_table(&table, table_path(format), table_layout(search_metric));
 
-    int depth = 0;
-    unsigned long long nodes_explored = 1;
+}
 
-    /*
-     * Repeatedly scan through the table, searching for nodes that were just
-     * explored. When one of these nodes is found, perform the 18 possible moves
-     * on it and record in the table.
-     */
-    while(nodes_explored > 0) {
+// Also prune with the symmetry-reduced table from symmetry.h.
+void init_symmetry_pruning(int flags, int num_threads) {
+    init_symmetry_table(flags, num_threads);
+    use_symmetry_table = true;
+}
 
-        nodes_explored = 0;
-        for(int i = 0; i < TABLE_SIZE; i++) {
-            
-            if(table[i] == depth) {
+// Also prune with the corner pattern database from cornerdb.h.
+void init_corner_pruning(int flags, int num_threads) {
+    init_corner_table(flags, num_threads);
+    use_corner_table = true;
+}
 
-                int ec = i / 4478976,
-                    eo = (i % 4478976) / 2187,
-                    co = i % 2187;
+// Also prune with the E-slice pattern database from slicedb.h.
+void init_slice_pruning(int flags, int num_threads) {
+    init_slice_table(flags, num_threads);
+    use_slice_table = true;
+}
 
-                for(int move = 0; move < 18; move++) {
+// Also prune with the edge pattern databases from edgedb.h.
+void init_edge_pruning(int flags, int num_threads) {
+    init_edge_tables(flags, num_threads);
+    use_edge_tables = true;
+}
 
-                    int next_coord = build_table_index(mult_co(co, move), mult_eo(eo, move), mult_ec(ec, move));
+/*
+ * Lower bound from any tables in use besides the main one, or 0 if there are
+ * none. Needs every coordinate of `cube`.
+ *
+ * The bound is the maximum over the tables, but we only need to know whether
+ * it reaches `cutoff`, so we stop at the first table that does. The tables are
+ * probed from cheapest to most expensive: the corner and E-slice databases
+ * are single lookups, the symmetry table needs a conjugation and the edge
+ * databases need their subsets ranked. Probes are counted in `stats`.
+ */
+int lookup_secondary_tables(CoordCube *cube, int cutoff, SearchStats *stats) {
+
+    int bound = 0;
+
+    if(use_corner_table) {
+        stats->lookups++;
+        bound = lookup_corner_table(cube);
+        if(bound >= cutoff) return bound;
+    }
 
-                    if(table[next_coord] > depth + 1) {
-                        table[next_coord] = depth + 1;
-                    }
+    if(use_slice_table) {
+        stats->lookups++;
+        int distance = lookup_slice_table(cube);
+        if(distance >= cutoff) return distance;
+        bound = distance > bound ? distance : bound;
+    }
 
-                    nodes_explored++;
+    if(use_symmetry_table) {
+        stats->lookups++;
+        int distance = lookup_symmetry_table(cube);
+        if(distance >= cutoff) return distance;
+        bound = distance > bound ? distance : bound;
+    }
 
-                }
+    if(use_edge_tables) {
+        for(int subset = 0; subset < NUM_EDGE_SUBSETS; subset++) {
+            stats->lookups++;
+            int distance = lookup_edge_table(cube, subset);
+            if(distance >= cutoff) return distance;
+            bound = distance > bound ? distance : bound;
+        }
+    }
 
-            }
+    return bound;
+
+}
+
+/*
+ * Also probe the main table with other states which are exactly as far from
+ * solved as the cube itself: its conjugates by the two rotations which bring
+ * its R-L and F-B axes onto U-D, its inverse and the two conjugates of its
+ * inverse. Each probe sees the cube from a different angle, so their maximum
+ * is a much tighter bound than the plain lookup, at the cost of some lookups
+ * into a table that is already resident.
+ *
+ * The conjugates are tracked with the move tables, since conjugating c*m gives
+ * the conjugate of c times another move. The inverse of c*m is m^-1 times the
+ * inverse of c, which the move tables can't do, so it is tracked as a CubeVec.
+ * The probes need exact values, so the main table can't be in mod 3 format.
+ */
+void init_extra_probes() {
+
+    if(table.format == PRUNE_MOD3) {
+        fprintf(stderr, "the inverse and symmetric probes need a byte or nibble pruning table\n");
+        exit(1);
+    }
+
+    init_symmetries();
+    init_cube_vecs();
+
+    static const int faces[2] = {FACE_R, FACE_F};
+    for(int axis = 0; axis < 2; axis++) {
 
+        int sym = 0;
+        while(symmetry_is_mirror(sym) || conjugate_move(faces[axis] * 3, sym) / 3 != FACE_U) {
+            sym++;
         }
 
-        printf("%llu nodes explored at depth %d\n", nodes_explored, depth);
-        depth++;
+        Cube rotation = *symmetry_cube(sym), inverse;
+        cube_inverse(&rotation, &inverse);
+        axis_syms[axis] = sym;
+        axis_vecs[axis] = cube_to_vec(&rotation);
+        axis_vec_inverses[axis] = cube_to_vec(&inverse);
 
     }
 
-    FILE *fp = fopen("corners.prune", "wb");
-    if(fp == NULL) {
-        perror("failed to open pruning table for writing");
-        exit(1);
+    use_extra_probes = true;
+
+}
+
+void init_search_node(SearchNode *node, CoordCube *cube) {
+
+    node->cube = *cube;
+    if(!use_extra_probes) {
+        return;
     }
 
-    if(fwrite(table, 1, TABLE_SIZE, fp) != TABLE_SIZE) {
-        perror("failed to write pruning table");
-        fclose(fp);
-        exit(1);
+    Cube state = coord_cube_to_cube(cube), inverse;
+    for(int axis = 0; axis < 2; axis++) {
+        Cube conj;
+        conjugate_cube(&state, axis_syms[axis], &conj);
+        node->axis_co[axis] = compute_co_coord(&conj);
+        node->axis_eo[axis] = compute_eo_coord(&conj);
+        node->axis_ec[axis] = compute_ec_coord(&conj);
+    }
+
+    cube_inverse(&state, &inverse);
+    node->inverse = cube_to_vec(&inverse);
+
+}
+
+// Apply `move` to the state of `node` used by the extra probes, if they're in use, writing it to `result`.
+void mult_extra_probes(SearchNode *node, int move, SearchNode *result) {
+
+    if(!use_extra_probes) {
+        return;
+    }
+
+    for(int axis = 0; axis < 2; axis++) {
+        int conj = conjugate_move(move, axis_syms[axis]);
+        result->axis_co[axis] = mult_co(node->axis_co[axis], conj);
+        result->axis_eo[axis] = mult_eo(node->axis_eo[axis], conj);
+        result->axis_ec[axis] = mult_ec(node->axis_ec[axis], conj);
+    }
+
+    int inverse_move = move_to_int(move / 3, move % 3 == TURN_FLIP ? TURN_FLIP : 1 - move % 3);
+    vec_multiply(&move_vecs[inverse_move], &node->inverse, &result->inverse);
+
+}
+
+int lookup_vec_distance(CubeVec *vec) {
+    return prune_get(&table, build_table_index(vec_co_coord(vec), vec_eo_coord(vec), vec_ec_coord(vec)));
+}
+
+/*
+ * Lower bound from the extra probes, or 0 if they aren't in use. Like
+ * lookup_secondary_tables(), stops as soon as a probe reaches `cutoff`.
+ */
+int lookup_extra_probes(SearchNode *node, int cutoff, SearchStats *stats) {
+
+    if(!use_extra_probes) {
+        return 0;
+    }
+
+    int bound = 0;
+    for(int axis = 0; axis < 2; axis++) {
+        stats->lookups++;
+        int distance = prune_get(&table, build_table_index(node->axis_co[axis], node->axis_eo[axis], node->axis_ec[axis]));
+        if(distance >= cutoff) return distance;
+        bound = distance > bound ? distance : bound;
+    }
+
+    stats->lookups++;
+    int distance = lookup_vec_distance(&node->inverse);
+    if(distance >= cutoff) return distance;
+    bound = distance > bound ? distance : bound;
+
+    for(int axis = 0; axis < 2; axis++) {
+        CubeVec tmp, conj;
+        vec_multiply(&axis_vecs[axis], &node->inverse, &tmp);
+        vec_multiply(&tmp, &axis_vec_inverses[axis], &conj);
+        stats->lookups++;
+        distance = lookup_vec_distance(&conj);
+        if(distance >= cutoff) return distance;
+        bound = distance > bound ? distance : bound;
     }
 
-    fclose(fp);    
-    calculate_table_stats();
+    return bound;
 
 }
 
-void init_pruning_table() {
+// Exact pruning value of the entry at `index`, for a cube whose parent had pruning value `parent_distance`.
+int lookup_index_distance(int index, int parent_distance) {
+    int value = prune_get(&table, index);
+    return table.format == PRUNE_MOD3 ? decode_mod3(value, parent_distance) : value;
+}
 
-    table = malloc(TABLE_SIZE);
+// Exact pruning value of a cube whose parent had pruning value `parent_distance`.
+int lookup_child_distance(CoordCube *cube, int parent_distance) {
+    return lookup_index_distance(build_table_index(cube->co, cube->eo, cube->ec), parent_distance);
+}
 
-    FILE *fp = fopen("corners.prune", "rb");
-    if(fp == NULL) {
-        perror("couldn't open pruning table");
-        build_pruning_table();
-    } else {
-        printf("loading pruning table...\n");
-        fread(table, 1, TABLE_SIZE, fp);
-        if(ferror(fp)) {
-            perror("failed to read pruning table");
-            fclose(fp);
-            exit(1);
+// Exact pruning value of a cube with no known parent.
+int lookup_pruning_table(CoordCube *cube) {
+
+    int index = build_table_index(cube->co, cube->eo, cube->ec);
+    if(table.format != PRUNE_MOD3) {
+        return prune_get(&table, index);
+    }
+
+    // Walk towards the solved state one move at a time, counting the steps.
+    const int *moves;
+    int num_moves = metric_moves(search_metric, &moves);
+    int co = cube->co, eo = cube->eo, ec = cube->ec, distance = 0;
+    while(index != 0) {
+        int value = prune_get(&table, index);
+        for(int i = 0; i < num_moves; i++) {
+            int move = moves[i];
+            int next = build_table_index(mult_co(co, move), mult_eo(eo, move), mult_ec(ec, move));
+            if(prune_get(&table, next) == (value + 2) % 3) {
+                co = mult_co(co, move);
+                eo = mult_eo(eo, move);
+                ec = mult_ec(ec, move);
+                index = next;
+                break;
+            }
         }
-        fclose(fp);
+        distance++;
     }
 
+    return distance;
+
 }
 
-bool search(Cube *cube, int last_turn_face, int depth, int max_depth, int *solution) {
+/*
+ * The search works entirely on coordinates; each child is produced by table
+ * lookups rather than by copying the parent and applying a move to it. We
+ * look up the pruning values before computing the rest of the child, since a
+ * solved child always has pruning values of 0 and most children are pruned.
+ *
+ * Nearly every probe into the main table is a cache (and TLB) miss, and
+ * probing each child as soon as it's computed leaves one miss outstanding at
+ * a time. So we compute the table index of every child up front and prefetch
+ * them all, letting the misses overlap, and only then go through the
+ * children in order.
+ *
+ * `distance` is the pruning value of `cube` itself, which the mod 3 table
+ * format needs to decode the values of the children. The moves leading to
+ * `node` must be in the first `depth` entries of `ctx->solution`, which holds
+ * the current path as the search goes.
+ */
+bool search(SearchContext *ctx, SearchNode *node, int distance, int depth, int max_depth) {
 
     if(depth == max_depth) {
         return false;
     }
 
-    for(int face = 0; face < 6; face++) {
-        
-        // don't evaluate moves that would cancel the previous one
-        if(last_turn_face == face)
-            continue;
+    if(ctx->out_of_budget || (ctx->cancel != NULL && atomic_load_explicit(ctx->cancel, memory_order_relaxed))) {
+        return false;
+    }
+
+    // reading the clock costs about as much as a node, so only do it every 1024 nodes
+    if((ctx->node_limit != 0 && ctx->stats.nodes >= ctx->node_limit) ||
+       (ctx->deadline_ms != 0 && (ctx->stats.nodes & 1023) == 0 && current_ms() >= ctx->deadline_ms)) {
+        ctx->out_of_budget = true;
+        return false;
+    }
+
+    ctx->stats.nodes++;
+    CoordCube *cube = &node->cube;
+
+    // first pass: find the main table entry of every child and prefetch it
+    int last = depth > 0 ? ctx->solution[depth - 1] : -1;
+    int repeated = depth > 1 && ctx->solution[depth - 2] == last;
+    const int *candidates = next_moves[repeated][last + 1];
+
+    int moves[18], indices[18], num_children = 0;
+    for(int i = 0; i < num_next_moves[repeated][last + 1]; i++) {
+        int move = candidates[i];
+        int index = build_table_index(mult_co(cube->co, move), mult_eo(cube->eo, move), mult_ec(cube->ec, move));
+        prune_prefetch(&table, index);
+        moves[num_children] = move;
+        indices[num_children++] = index;
+    }
+
+    // second pass: by now the first entries should have arrived
+    for(int i = 0; i < num_children; i++) {
 
-        // turns of opposite faces are commutative, we only need to evaluate
-        // each combination once
-        if((last_turn_face == FACE_D && face == FACE_U) ||
-           (last_turn_face == FACE_R && face == FACE_L) ||
-           (last_turn_face == FACE_B && face == FACE_F))
+        int move = moves[i];
+
+        // try to prune
+        int remaining_moves = lookup_index_distance(indices[i], distance);
+        ctx->stats.lookups++;
+        if(depth + remaining_moves >= max_depth) {
             continue;
-        
-        for(int degree = 0; degree < 3; degree++) {
-
-            Cube next = *cube;
-            do_move(&next, face, degree);
-            
-            // if we've solved the cube, rejoice!
-            if(is_solved(&next)) {
-                solution[depth] = move_to_int(face, degree);
-                return true;
-            }
+        }
 
-            // try to prune
-            int remaining_moves = table[build_table_index(compute_co_coord(&next), compute_eo_coord(&next), compute_ec_coord(&next))];
-            if(depth + remaining_moves >= max_depth) {
+        SearchNode child;
+        CoordCube *next = &child.cube;
+        next->co = mult_co(cube->co, move);
+        next->eo = mult_eo(cube->eo, move);
+        next->ec = mult_ec(cube->ec, move);
+
+        if(use_extra_probes) {
+            mult_extra_probes(node, move, &child);
+            if(depth + lookup_extra_probes(&child, max_depth - depth, &ctx->stats) >= max_depth) {
                 continue;
             }
+        }
 
-            // recursively search
-            if(search(&next, face, depth + 1, max_depth, solution)) {
-                solution[depth] = move_to_int(face, degree);
-                return true;
-            }
+        next->cp = mult_cp(cube->cp, move);
+        next->e_edges = mult_eslice(cube->e_edges, move);
+        next->u_edges = mult_eslice(cube->u_edges, move);
+        next->d_edges = mult_eslice(cube->d_edges, move);
+        if(depth + lookup_secondary_tables(next, max_depth - depth, &ctx->stats) >= max_depth) {
+            continue;
+        }
 
+        // if we've solved the cube, rejoice!
+        ctx->solution[depth] = move;
+        if(is_coord_cube_solved(next)) {
+            return true;
+        }
+
+        // recursively search
+        if(search(ctx, &child, remaining_moves, depth + 1, max_depth)) {
+            return true;
         }
 
     }
 
     return false;
 
-}
\ No newline at end of file
+}
+
+double current_ms() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1e3 + now.tv_nsec / 1e6;
+}
+
+/*
+ * Find an optimal solution with IDA*, using `num_threads` threads and staying
+ * within `budget` (which may be NULL). The first depth searched is the best
+ * bound any of the tables in use gives for the cube, and every depth searched
+ * without finding a solution raises the proven lower bound by one. Returns
+ * true if an optimal solution was found, and false if the budget ran out or
+ * the cube is unsolvable; `result` is filled in either way.
+ */
+/*
+ * The bound IDA* starts from: the largest lower bound from the main table and
+ * whichever other tables and probes are in use. `node` must have been set up
+ * from `cube` with init_search_node(). Probes are counted in `stats`.
+ */
+int initial_search_bound(CoordCube *cube, SearchNode *node, SearchStats *stats) {
+
+    int diameter = metric_diameter(search_metric);
+    int bound = lookup_pruning_table(cube);
+    int extra = lookup_extra_probes(node, diameter + 1, stats), secondary = lookup_secondary_tables(cube, diameter + 1, stats);
+    bound = extra > bound ? extra : bound;
+    return secondary > bound ? secondary : bound;
+
+}
+
+bool solve_optimal(CoordCube *cube, SearchBudget *budget, int num_threads, OptimalResult *result) {
+
+    double start = current_ms();
+
+    SearchContext ctx = {result->solution, NULL, {0, 0}};
+    if(budget != NULL) {
+        ctx.node_limit = budget->max_nodes;
+        ctx.deadline_ms = budget->max_ms != 0 ? start + budget->max_ms : 0;
+    }
+
+    SearchNode node;
+    init_search_node(&node, cube);
+
+    int diameter = metric_diameter(search_metric);
+    int distance = lookup_pruning_table(cube);
+    int bound = initial_search_bound(cube, &node, &ctx.stats);
+
+    result->length = -1;
+    if(is_coord_cube_solved(cube)) {
+        result->length = bound = 0;
+    }
+
+    for(; result->length < 0 && bound <= diameter; bound++) {
+
+        bool found = num_threads > 1 ? parallel_search(&ctx, cube, bound, num_threads)
+                                     : search(&ctx, &node, distance, 0, bound);
+        if(found) {
+            result->length = bound;
+            break;
+        }
+
+        if(ctx.out_of_budget) {
+            break;
+        }
+
+    }
+
+    result->lower_bound = bound;
+    result->stats = ctx.stats;
+    result->ms = current_ms() - start;
+    return result->length >= 0;
+
+}
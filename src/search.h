@@ -1,6 +1,13 @@
 #ifndef __PRUNE_TABLE_H
 #define __PRUNE_TABLE_H
 
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "coordinates.h"
+#include "cubevec.h"
+#include "prune.h"
+
 /*
  * Our algorithm of choice for searching the Rubik's cube game tree is iter-
  * ative deepening A*. In a nutshell, IDA* conducts depth first searches of
@@ -17,13 +24,95 @@
  * branching factor of 18 (since without information on the last turned face
  * we cannot eliminate redundant branches), but this is not a big problem since
  * the computational cost of building the pruning table is amortized across
- * solves, so as long as it completes in a *reasonable* amount of time per-
- * formance is not important.
+ * solves. Generation is still split across threads, and switches to searching
+ * backwards from unvisited entries once most of the table has been reached
+ * (see generate_prune_table() in prune.c).
  * 
+ * The table can be stored one byte per entry, or packed; see prune.h.
+ *
  * See coordinates.h for more information on the mathematics of pruning tables.
  *  
  */
 
-void init_pruning_table();
+// Counters for benchmarking; lookups counts probes of every pruning table.
+typedef struct {
+    uint64_t nodes;
+    uint64_t lookups;
+} SearchStats;
+
+/*
+ * A node of the search: the cube's coordinates, plus what the extra probes of
+ * the main pruning table need if they're in use (see init_extra_probes()):
+ * the co, eo and ec coordinates of the cube conjugated so that its R-L and
+ * F-B axes become the U-D axis, and the inverse of the cube.
+ */
+typedef struct {
+    CoordCube cube;
+    uint16_t axis_co[2];
+    uint16_t axis_eo[2];
+    uint16_t axis_ec[2];
+    CubeVec inverse;
+} SearchNode;
+
+/*
+ * Per-search state. `solution` receives the moves of the solution, indexed by
+ * depth. If `cancel` is not NULL, the search gives up as soon as it is set,
+ * which lets several threads stop once one of them has found a solution.
+ * `stats` is added to as the search goes.
+ *
+ * The search also gives up, setting `out_of_budget`, once `stats.nodes`
+ * reaches `node_limit` or the monotonic clock (see current_ms()) passes
+ * `deadline_ms`. Either may be 0 for no limit.
+ */
+typedef struct {
+    int *solution;
+    atomic_bool *cancel;
+    SearchStats stats;
+    uint64_t node_limit;
+    double deadline_ms;
+    bool out_of_budget;
+} SearchContext;
+
+// Limits on the work solve_optimal() may do. Either may be 0 for no limit.
+typedef struct {
+    uint64_t max_nodes;
+    double max_ms;
+} SearchBudget;
+
+/*
+ * What solve_optimal() found out about a cube. `lower_bound` is proven: there
+ * is no solution with fewer moves. If a solution was found, it is optimal and
+ * `length` equals `lower_bound`; otherwise `length` is -1 and the budget ran
+ * out while looking for solutions of `lower_bound` moves. Lengths are in the
+ * metric of the pruning table, and a lower bound above the diameter of that
+ * metric (see metric_diameter()) means the cube can't be solved at all.
+ */
+typedef struct {
+    int length;
+    int solution[32];
+    int lower_bound;
+    SearchStats stats;
+    double ms;
+} OptimalResult;
+
+void main_table_spec(int metric, PruneSpec *spec);
+void init_pruning_table(int format, int metric, int flags, int num_threads);
+void init_symmetry_pruning(int flags, int num_threads);
+void init_corner_pruning(int flags, int num_threads);
+void init_slice_pruning(int flags, int num_threads);
+void init_edge_pruning(int flags, int num_threads);
+void init_extra_probes();
+void init_search_node(SearchNode *node, CoordCube *cube);
+void mult_extra_probes(SearchNode *node, int move, SearchNode *result);
+int lookup_extra_probes(SearchNode *node, int cutoff, SearchStats *stats);
+int lookup_secondary_tables(CoordCube *cube, int cutoff, SearchStats *stats);
+int lookup_pruning_table(CoordCube *cube);
+int lookup_child_distance(CoordCube *cube, int parent_distance);
+double current_ms();
+int initial_search_bound(CoordCube *cube, SearchNode *node, SearchStats *stats);
+bool solve_optimal(CoordCube *cube, SearchBudget *budget, int num_threads, OptimalResult *result);
+int search_move_set(const int **moves);
+bool is_canonical_move(const int *path, int depth, int move);
+bool search(SearchContext *ctx, SearchNode *node, int distance, int depth, int max_depth);
 
 #endif
\ No newline at end of file
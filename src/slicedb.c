@@ -0,0 +1,49 @@
+#include "slicedb.h"
+#include "prune.h"
+#include <stdio.h>
+
+#define SLICE_LAYOUT "eslice:11880 eo:2048"
+
+PruneTable slice_table;
+
+void slice_table_neighbours(uint64_t index, const int *moves, int num_moves, uint64_t *out) {
+    int eslice = index / 2048, eo = index % 2048;
+    for(int i = 0; i < num_moves; i++) {
+        out[i] = (uint64_t)mult_eslice(eslice, moves[i]) * 2048 + mult_eo(eo, moves[i]);
+    }
+}
+
+// How to generate the table for `metric`, without checkpoints.
+void slice_table_spec(int metric, PruneSpec *spec) {
+    const int *moves;
+    int num_moves = metric_moves(metric, &moves);
+    *spec = (PruneSpec){SLICE_TABLE_SIZE, 0, moves, num_moves, slice_table_neighbours, NULL, SLICE_LAYOUT};
+}
+
+void init_slice_table(int flags, int num_threads) {
+
+    const char *path = "eslice.prune";
+    fprintf(stderr, "loading pruning table %s...\n", path);
+
+    int result = load_prune_table(&slice_table, path, SLICE_LAYOUT, SLICE_TABLE_SIZE, PRUNE_NIBBLE, flags);
+    if(result == PRUNE_OK) {
+        return;
+    }
+
+    fprintf(stderr, "couldn't load pruning table %s: %s\n", path, prune_error_string(result));
+    fprintf(stderr, "building E-slice pattern database...\n");
+
+    PruneSpec spec;
+    slice_table_spec(METRIC_HTM, &spec);
+    spec.path = path;
+
+    alloc_prune_table(&slice_table, SLICE_TABLE_SIZE, PRUNE_NIBBLE);
+    generate_prune_table(&spec, &slice_table, num_threads);
+    save_prune_table(&slice_table, path, SLICE_LAYOUT);
+
+}
+
+// Exact number of moves needed to orient every edge and solve the E-slice edges.
+int lookup_slice_table(CoordCube *cube) {
+    return prune_get(&slice_table, (uint64_t)cube->e_edges * 2048 + cube->eo);
+}
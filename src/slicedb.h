@@ -0,0 +1,24 @@
+#ifndef __SLICEDB_H
+#define __SLICEDB_H
+
+#include "coordinates.h"
+#include "prune.h"
+
+/*
+ * E-slice pattern database.
+ *
+ * The main table only knows where one edge is (through the 96-value ec
+ * coordinate), and the symmetry table only knows which positions the E-slice
+ * edges occupy. This table pairs EO with the full E-slice coordinate, which
+ * also tracks the order of the slice edges: 2048 * 11880 = 24,330,240 exact
+ * distances in nibble format (12MB). It is small, but catches positions whose
+ * slice edges are solved as a set but permuted among themselves.
+ */
+
+#define SLICE_TABLE_SIZE 24330240 // 11880 * 2048
+
+void slice_table_spec(int metric, PruneSpec *spec);
+void init_slice_table(int flags, int num_threads);
+int lookup_slice_table(CoordCube *cube);
+
+#endif
@@ -0,0 +1,251 @@
+#include "statefile.h"
+#include "coordinates.h"
+#include <string.h>
+
+#define EP_HALVES 239500800 // 12! / 2
+
+/*
+ * Lehmer code of a permutation of 0..n-1, like rank_permutation(), but in
+ * linear time: the elements after i which are smaller than perm[i] are the
+ * smaller ones that haven't been seen yet.
+ */
+int rank_full_permutation(const uint8_t *perm, int n) {
+    int rank = 0, seen_mask = 0;
+    for(int i = 0; i < n; i++) {
+        rank = rank * (n - i) + perm[i] - __builtin_popcount(seen_mask & ((1 << perm[i]) - 1));
+        seen_mask |= 1 << perm[i];
+    }
+    return rank;
+}
+
+/*
+ * ceil(2^36 / d). Multiplying a number below 2^29 by one of these (for d of 2
+ * to 12) and shifting right by 36 divides it by d exactly, which is much
+ * faster than dividing by a divisor the compiler doesn't know.
+ */
+#define RECIPROCAL(d) (((1ULL << 36) + (d) - 1) / (d))
+
+const uint64_t reciprocals[13] = {
+    0, 0, RECIPROCAL(2), RECIPROCAL(3), RECIPROCAL(4), RECIPROCAL(5), RECIPROCAL(6),
+    RECIPROCAL(7), RECIPROCAL(8), RECIPROCAL(9), RECIPROCAL(10), RECIPROCAL(11), RECIPROCAL(12)
+};
+
+/*
+ * The inverse of rank_full_permutation(), returning the permutation's parity
+ * (the parity of the sum of the Lehmer digits). Each element is the
+ * digit'th lowest bit still set in the mask of unused elements.
+ */
+int unrank_full_permutation(int rank, uint8_t *perm, int n) {
+
+    // the last digit has radix 1, so it's always 0
+    int digits[12], digit_sum = 0;
+    digits[n - 1] = 0;
+    for(int i = n - 2; i >= 0; i--) {
+        int quotient = rank * reciprocals[n - i] >> 36;
+        digits[i] = rank - quotient * (n - i);
+        rank = quotient;
+        digit_sum += digits[i];
+    }
+
+    uint32_t unused_mask = (1 << n) - 1;
+    for(int i = 0; i < n; i++) {
+        uint32_t mask = unused_mask;
+        for(int skip = digits[i]; skip > 0; skip--) {
+            mask &= mask - 1;
+        }
+        perm[i] = __builtin_ctz(mask);
+        unused_mask &= ~(1 << perm[i]);
+    }
+
+    return digit_sum & 1;
+
+}
+
+CubeRank rank_cube(Cube *cube) {
+
+    uint64_t cp = rank_full_permutation(cube->corners, 8);
+    uint64_t ep = rank_full_permutation(cube->edges, 12);
+
+    uint64_t high_part = (cp * 2187 + compute_co_coord(cube)) * EP_HALVES + ep / 2;
+
+    // high_part has 55 bits, so shifting it past the 11 EO bits spills into the high word
+    CubeRank rank;
+    rank.low = high_part << 11 | compute_eo_coord(cube);
+    rank.high = high_part >> 53;
+    return rank;
+
+}
+
+/*
+ * Set a cube from its rank, returning false if the rank is out of range (in
+ * which case the cube is left untouched).
+ */
+bool unrank_cube(CubeRank rank, Cube *cube) {
+
+    if(rank.high > CUBE_STATES_HIGH || (rank.high == CUBE_STATES_HIGH && rank.low >= CUBE_STATES_LOW)) {
+        return false;
+    }
+
+    uint64_t high_part = rank.high << 53 | rank.low >> 11;
+
+    int corner = high_part / EP_HALVES;
+    int ep = high_part % EP_HALVES * 2;
+
+    int corner_parity = unrank_full_permutation(corner / 2187, cube->corners, 8);
+    set_co_coord(cube, corner % 2187);
+
+    /*
+     * ep / 2 dropped the second-to-last Lehmer digit, and unranking with it
+     * as 0 leaves the last two edges in order. If that gives the wrong
+     * parity, the digit was 1 and those edges are swapped.
+     */
+    if(unrank_full_permutation(ep, cube->edges, 12) != corner_parity) {
+        uint8_t tmp = cube->edges[10];
+        cube->edges[10] = cube->edges[11];
+        cube->edges[11] = tmp;
+    }
+    set_eo_coord(cube, rank.low & 2047);
+
+    return true;
+
+}
+
+int write_state_header(StateFile *file, FILE *fp, uint32_t flags) {
+
+    StateFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, STATE_FILE_MAGIC, 8);
+    header.version = STATE_FILE_VERSION;
+    header.flags = flags;
+
+    file->fp = fp;
+    file->flags = flags;
+    file->records = 0;
+
+    return fwrite(&header, sizeof(header), 1, fp) == 1 ? STATE_OK : STATE_ERR_IO;
+
+}
+
+/*
+ * Append a cube to a state file. If the file has solutions, `length` is the
+ * length of `solution`, or -1 if there isn't one.
+ */
+int write_state(StateFile *file, Cube *cube, const int *solution, int length) {
+
+    uint8_t record[STATE_RANK_BYTES + 1 + STATE_MAX_MOVES];
+    size_t size = STATE_RANK_BYTES;
+
+    CubeRank rank = rank_cube(cube);
+    for(int i = 0; i < 8; i++) {
+        record[i] = rank.low >> (i * 8);
+    }
+    record[8] = rank.high;
+
+    if(file->flags & STATE_FILE_SOLUTIONS) {
+        if(length > STATE_MAX_MOVES) {
+            return STATE_ERR_MOVE;
+        }
+        record[size++] = length < 0 ? STATE_NO_SOLUTION : length;
+        for(int i = 0; i < length; i++) {
+            record[size++] = solution[i];
+        }
+    }
+
+    if(fwrite(record, 1, size, file->fp) != size) {
+        return STATE_ERR_IO;
+    }
+    file->records++;
+    return STATE_OK;
+
+}
+
+int read_state_header(StateFile *file, FILE *fp) {
+
+    StateFileHeader header;
+    if(fread(&header, sizeof(header), 1, fp) != 1) {
+        return ferror(fp) ? STATE_ERR_IO : STATE_ERR_TRUNCATED;
+    }
+    if(memcmp(header.magic, STATE_FILE_MAGIC, 8) != 0) {
+        return STATE_ERR_MAGIC;
+    }
+    if(header.version != STATE_FILE_VERSION) {
+        return STATE_ERR_VERSION;
+    }
+
+    file->fp = fp;
+    file->flags = header.flags;
+    file->records = 0;
+    return STATE_OK;
+
+}
+
+/*
+ * Read the next cube from a state file, returning STATE_END once there are
+ * no more. If the file has solutions, the solution (at most STATE_MAX_MOVES
+ * moves) and its length (-1 if there isn't one) are stored in `solution` and
+ * `length`; otherwise `length` is set to -1. Either may be NULL.
+ */
+int read_state(StateFile *file, Cube *cube, int *solution, int *length) {
+
+    uint8_t record[STATE_RANK_BYTES + 1 + STATE_MAX_MOVES];
+
+    size_t read = fread(record, 1, STATE_RANK_BYTES, file->fp);
+    if(read != STATE_RANK_BYTES) {
+        return ferror(file->fp) ? STATE_ERR_IO : read == 0 ? STATE_END : STATE_ERR_TRUNCATED;
+    }
+
+    CubeRank rank = {0, record[8]};
+    for(int i = 0; i < 8; i++) {
+        rank.low |= (uint64_t)record[i] << (i * 8);
+    }
+    if(!unrank_cube(rank, cube)) {
+        return STATE_ERR_RANK;
+    }
+
+    int moves = -1;
+    if(file->flags & STATE_FILE_SOLUTIONS) {
+        int c = fgetc(file->fp);
+        if(c == EOF) {
+            return ferror(file->fp) ? STATE_ERR_IO : STATE_ERR_TRUNCATED;
+        }
+        if(c != STATE_NO_SOLUTION) {
+            if(c > STATE_MAX_MOVES) {
+                return STATE_ERR_MOVE;
+            }
+            size_t count = c;
+            if(fread(record, 1, count, file->fp) != count) {
+                return ferror(file->fp) ? STATE_ERR_IO : STATE_ERR_TRUNCATED;
+            }
+            for(size_t i = 0; i < count; i++) {
+                if(record[i] >= 18) {
+                    return STATE_ERR_MOVE;
+                }
+                if(solution != NULL) {
+                    solution[i] = record[i];
+                }
+            }
+            moves = c;
+        }
+    }
+
+    if(length != NULL) {
+        *length = moves;
+    }
+    file->records++;
+    return STATE_OK;
+
+}
+
+const char *state_error_string(int error) {
+    switch(error) {
+        case STATE_OK: return "success";
+        case STATE_END: return "end of file";
+        case STATE_ERR_IO: return "I/O error";
+        case STATE_ERR_TRUNCATED: return "file is truncated";
+        case STATE_ERR_MAGIC: return "not a state file";
+        case STATE_ERR_VERSION: return "unsupported state file version";
+        case STATE_ERR_RANK: return "cube rank out of range";
+        case STATE_ERR_MOVE: return "invalid solution";
+        default: return "unknown error";
+    }
+}
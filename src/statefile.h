@@ -0,0 +1,89 @@
+#ifndef __STATEFILE_H
+#define __STATEFILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "cube.h"
+
+/*
+ * Compact cube encoding.
+ *
+ * A Cube takes 40 bytes, but there are only 8! * 3^7 * 12! * 2^11 / 2 =
+ * 43,252,003,274,489,856,000 legal states, so every state can be given an
+ * exact rank of 66 bits:
+ *
+ *     rank = ((cp * 2187 + co) * (12! / 2) + ep / 2) * 2048 + eo
+ *
+ * cp and ep are the Lehmer codes of the corner and edge permutations and co
+ * and eo the usual orientation coordinates (see coordinates.h). The last
+ * two digits of a Lehmer code are the only ones with radices 2 and 1, so the
+ * second-to-last one is all that ep / 2 drops, and it's fixed by the parity
+ * of the corners. The solved cube has rank 0, and ranks compare the way the
+ * coordinates do, so sorting states by rank groups them by corners first.
+ */
+
+#define CUBE_STATES_HIGH 2                     // CUBE_STATES >> 64
+#define CUBE_STATES_LOW  0x583DFBD1B8000000ULL // CUBE_STATES & (2^64 - 1)
+
+typedef struct {
+    uint64_t low;
+    uint64_t high;  // only the lowest two bits are used
+} CubeRank;
+
+CubeRank rank_cube(Cube *cube);
+bool unrank_cube(CubeRank rank, Cube *cube);
+
+/*
+ * State files.
+ *
+ * A binary format for passing large sets of cubes between programs without
+ * parsing text. A file is a header followed by one record per cube, with no
+ * index or count, so files can be written and read as streams (through
+ * pipes, say) and simply concatenated after dropping the later headers.
+ *
+ * Each record starts with the cube's rank in 9 bytes, least significant
+ * first. If the header has STATE_FILE_SOLUTIONS set, that's followed by the
+ * length of a solution in one byte (STATE_NO_SOLUTION if there isn't one)
+ * and then its moves, one byte each (face * 3 + degree).
+ */
+
+#define STATE_FILE_MAGIC   "CUBESTAT"
+#define STATE_FILE_VERSION 1
+
+// header flags
+#define STATE_FILE_SOLUTIONS 1
+
+#define STATE_RANK_BYTES  9
+#define STATE_NO_SOLUTION 0xff
+#define STATE_MAX_MOVES   32  // longest solution a record may hold
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+} StateFileHeader;
+
+typedef struct {
+    FILE *fp;
+    uint32_t flags;
+    uint64_t records;  // records read or written so far
+} StateFile;
+
+// results of the state file functions
+#define STATE_OK            0
+#define STATE_END           1  // no more records
+#define STATE_ERR_IO        2
+#define STATE_ERR_TRUNCATED 3
+#define STATE_ERR_MAGIC     4
+#define STATE_ERR_VERSION   5
+#define STATE_ERR_RANK      6  // a rank beyond the number of cube states
+#define STATE_ERR_MOVE      7  // a solution that's too long or has a bad move
+
+int write_state_header(StateFile *file, FILE *fp, uint32_t flags);
+int write_state(StateFile *file, Cube *cube, const int *solution, int length);
+int read_state_header(StateFile *file, FILE *fp);
+int read_state(StateFile *file, Cube *cube, int *solution, int *length);
+const char *state_error_string(int error);
+
+#endif
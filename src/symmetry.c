@@ -0,0 +1,405 @@
+#include "symmetry.h"
+#include "prune.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FLIPSLICE_TABLE_SIZE ((uint64_t)FLIPSLICE_CLASSES * 2187)
+#define FLIPSLICE_LAYOUT "co:2187 flipslice-class:64430"
+
+Cube symmetries[NUM_SYMMETRIES];
+Cube symmetry_cube_inverses[NUM_SYMMETRIES];
+int symmetry_inverses[NUM_SYMMETRIES];
+int symmetry_moves[NUM_SYMMETRIES][18];
+int symmetry_faces[NUM_SYMMETRIES][6];
+bool symmetry_mirrors[NUM_SYMMETRIES];
+
+uint16_t *co_conj_table;         // co * 16 + sym
+uint16_t *flipslice_class_table; // raw flip-slice -> class index
+uint8_t *flipslice_sym_table;    // raw flip-slice -> symmetry mapping it to its class representative
+uint32_t *flipslice_reps;        // class index -> raw flip-slice
+uint16_t *flipslice_stabilizers; // class index -> mask of symmetries fixing its representative
+
+PruneTable symmetry_table;
+
+// Position vectors, with x pointing right, y up and z to the front.
+const int face_vectors[6][3] = {
+    {0, 1, 0}, {0, -1, 0}, {-1, 0, 0}, {1, 0, 0}, {0, 0, -1}, {0, 0, 1}
+};
+
+const int corner_vectors[8][3] = {
+    {-1, 1, -1}, {-1, 1, 1}, {1, 1, -1}, {1, 1, 1},
+    {-1, -1, -1}, {-1, -1, 1}, {1, -1, -1}, {1, -1, 1}
+};
+
+const int edge_vectors[12][3] = {
+    {-1, 1, 0}, {1, 1, 0}, {0, 1, -1}, {0, 1, 1},
+    {-1, -1, 0}, {1, -1, 0}, {0, -1, -1}, {0, -1, 1},
+    {-1, 0, 1}, {1, 0, 1}, {-1, 0, -1}, {1, 0, -1}
+};
+
+bool corners_equal(Cube *a, Cube *b) {
+    return memcmp(a->corners, b->corners, 8) == 0 && memcmp(a->corner_orientations, b->corner_orientations, 8) == 0;
+}
+
+bool edges_equal(Cube *a, Cube *b) {
+    return memcmp(a->edges, b->edges, 12) == 0 && memcmp(a->edge_orientations, b->edge_orientations, 12) == 0;
+}
+
+int find_vector(const int vectors[][3], int count, int *v) {
+    for(int i = 0; i < count; i++) {
+        if(vectors[i][0] == v[0] && vectors[i][1] == v[1] && vectors[i][2] == v[2]) return i;
+    }
+    return -1;
+}
+
+void transform_vector(int *axes, int *signs, const int *v, int *result) {
+    for(int i = 0; i < 3; i++) {
+        result[i] = signs[i] * v[axes[i]];
+    }
+}
+
+/*
+ * Check that conjugating by `sym` maps every quarter turn onto a quarter turn
+ * of the expected face, comparing either corners or edges.
+ */
+bool is_symmetry(Cube *sym, Cube *quarter_turns, int *faces, bool mirror, bool corners) {
+    for(int face = 0; face < 6; face++) {
+        Cube lhs, rhs;
+        cube_multiply(&quarter_turns[face], sym, &lhs);
+        cube_multiply(sym, &quarter_turns[faces[face] + (mirror ? 6 : 0)], &rhs);
+        if(corners ? !corners_equal(&lhs, &rhs) : !edges_equal(&lhs, &rhs)) return false;
+    }
+    return true;
+}
+
+/*
+ * Work out the cubie representation of the symmetry of space given by a
+ * signed permutation of the axes. The permutation of positions follows from
+ * geometry; we find the orientations by trying every possibility until we
+ * find one where X * S = S * Y for every quarter turn X, where Y is the turn
+ * of the face that S maps X's face onto (counter-clockwise for reflections).
+ */
+void derive_symmetry(int *axes, int *signs, bool mirror, Cube *quarter_turns, Cube *sym, int *faces) {
+
+    for(int face = 0; face < 6; face++) {
+        int v[3];
+        transform_vector(axes, signs, face_vectors[face], v);
+        faces[face] = find_vector(face_vectors, 6, v);
+    }
+
+    *sym = create_solved_cube();
+    for(int i = 0; i < 8; i++) {
+        int v[3];
+        transform_vector(axes, signs, corner_vectors[i], v);
+        sym->corners[find_vector(corner_vectors, 8, v)] = i;
+    }
+    for(int i = 0; i < 12; i++) {
+        int v[3];
+        transform_vector(axes, signs, edge_vectors[i], v);
+        sym->edges[find_vector(edge_vectors, 12, v)] = i;
+    }
+
+    bool found = false;
+    for(int co = 0; co < 6561 && !found; co++) {
+        for(int i = 0, x = co; i < 8; i++, x /= 3) {
+            sym->corner_orientations[i] = x % 3 + (mirror ? 3 : 0);
+        }
+        found = is_symmetry(sym, quarter_turns, faces, mirror, true);
+    }
+
+    if(!found) {
+        fprintf(stderr, "couldn't derive corners of symmetry\n");
+        exit(1);
+    }
+
+    found = false;
+    for(int eo = 0; eo < 4096 && !found; eo++) {
+        for(int i = 0; i < 12; i++) {
+            sym->edge_orientations[i] = (eo >> i) & 1;
+        }
+        found = is_symmetry(sym, quarter_turns, faces, mirror, false);
+    }
+
+    if(!found) {
+        fprintf(stderr, "couldn't derive edges of symmetry\n");
+        exit(1);
+    }
+
+}
+
+void init_symmetries() {
+
+    // clockwise quarter turns, followed by counter-clockwise quarter turns
+    Cube quarter_turns[12];
+    for(int face = 0; face < 6; face++) {
+        quarter_turns[face] = move_cubes[face * 3 + TURN_CW];
+        quarter_turns[face + 6] = move_cubes[face * 3 + TURN_CCW];
+    }
+
+    static const int axis_perms[6][3] = {{0, 1, 2}, {2, 1, 0}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}};
+
+    /*
+     * Enumerate the signed permutations of the axes, putting the ones which
+     * keep the y (U-D) axis in place first. The identity comes first of all.
+     */
+    int count = 0;
+    for(int pass = 0; pass < 2; pass++) {
+        for(int p = 0; p < 6; p++) {
+            int *axes = (int *)axis_perms[p];
+            if((axes[1] == 1) != (pass == 0)) continue;
+            for(int s = 0; s < 8; s++) {
+
+                int signs[3] = {s & 1 ? -1 : 1, s & 2 ? -1 : 1, s & 4 ? -1 : 1};
+
+                // the determinant of a signed permutation matrix
+                int parity = (p == 0 || p == 4 || p == 5) ? 1 : -1;
+                bool mirror = parity * signs[0] * signs[1] * signs[2] < 0;
+
+                derive_symmetry(axes, signs, mirror, quarter_turns, &symmetries[count], symmetry_faces[count]);
+                symmetry_mirrors[count] = mirror;
+                count++;
+
+            }
+        }
+    }
+
+    /*
+     * Twisting every corner or flipping every edge commutes with all moves, so
+     * the orientations we found are only determined up to such a change, and
+     * the product of a symmetry and its inverse in our list might be one of
+     * those rather than the identity. This doesn't matter for conjugation, but
+     * we do need to find inverses by comparing permutations alone.
+     */
+    for(int i = 0; i < NUM_SYMMETRIES; i++) {
+        cube_inverse(&symmetries[i], &symmetry_cube_inverses[i]);
+        for(int j = 0; j < NUM_SYMMETRIES; j++) {
+            if(memcmp(symmetry_cube_inverses[i].corners, symmetries[j].corners, 8) == 0 && memcmp(symmetry_cube_inverses[i].edges, symmetries[j].edges, 12) == 0) {
+                symmetry_inverses[i] = j;
+                break;
+            }
+        }
+    }
+
+    // any twist or flip in a symmetry cancels out in a conjugate, so these match move cubes exactly
+    for(int i = 0; i < NUM_SYMMETRIES; i++) {
+        for(int move = 0; move < 18; move++) {
+            Cube conj;
+            conjugate_cube(&move_cubes[move], i, &conj);
+            for(int j = 0; j < 18; j++) {
+                if(memcmp(&conj, &move_cubes[j], sizeof(Cube)) == 0) {
+                    symmetry_moves[i][move] = j;
+                    break;
+                }
+            }
+        }
+    }
+
+}
+
+// Compute S*c*S^-1.
+void conjugate_cube(Cube *cube, int sym, Cube *result) {
+    Cube tmp;
+    cube_multiply(&symmetries[sym], cube, &tmp);
+    cube_multiply(&tmp, &symmetry_cube_inverses[sym], result);
+}
+
+int symmetry_inverse(int sym) {
+    return symmetry_inverses[sym];
+}
+
+const Cube *symmetry_cube(int sym) {
+    return &symmetries[sym];
+}
+
+// The move S*m*S^-1, so that conjugating c*m gives the conjugate of c times this move.
+int conjugate_move(int move, int sym) {
+    return symmetry_moves[sym][move];
+}
+
+// The face that `sym` maps `face` onto.
+int symmetry_face(int sym, int face) {
+    return symmetry_faces[sym][face];
+}
+
+bool symmetry_is_mirror(int sym) {
+    return symmetry_mirrors[sym];
+}
+
+// flip-slice = E-slice position * 2048 + EO
+int conjugate_flipslice(int flipslice, int sym) {
+
+    Cube cube = create_solved_cube(), conj;
+    set_eslice_coord(&cube, flipslice / 2048 * 24);
+    set_eo_coord(&cube, flipslice % 2048);
+
+    conjugate_cube(&cube, sym, &conj);
+    return compute_eslice_coord(&conj) / 24 * 2048 + compute_eo_coord(&conj);
+
+}
+
+void init_sym_coords() {
+
+    co_conj_table = malloc(2187 * NUM_UD_SYMMETRIES * sizeof(uint16_t));
+    for(int co = 0; co < 2187; co++) {
+        Cube cube = create_solved_cube();
+        set_co_coord(&cube, co);
+        for(int sym = 0; sym < NUM_UD_SYMMETRIES; sym++) {
+            Cube conj;
+            conjugate_cube(&cube, sym, &conj);
+            co_conj_table[co * NUM_UD_SYMMETRIES + sym] = compute_co_coord(&conj);
+        }
+    }
+
+    flipslice_class_table = malloc(FLIPSLICE_RAW * sizeof(uint16_t));
+    flipslice_sym_table = malloc(FLIPSLICE_RAW);
+    flipslice_reps = malloc(FLIPSLICE_CLASSES * sizeof(uint32_t));
+    flipslice_stabilizers = malloc(FLIPSLICE_CLASSES * sizeof(uint16_t));
+    memset(flipslice_class_table, 0xff, FLIPSLICE_RAW * sizeof(uint16_t));
+
+    /*
+     * The first member of each class we come across becomes its
+     * representative. Conjugating it by every symmetry finds the rest.
+     */
+    int classes = 0;
+    for(int raw = 0; raw < FLIPSLICE_RAW; raw++) {
+
+        if(flipslice_class_table[raw] != 0xffff) continue;
+
+        flipslice_reps[classes] = raw;
+        flipslice_stabilizers[classes] = 0;
+
+        for(int sym = 0; sym < NUM_UD_SYMMETRIES; sym++) {
+            int conj = conjugate_flipslice(raw, sym);
+            if(conj == raw) {
+                flipslice_stabilizers[classes] |= 1 << sym;
+            }
+            if(flipslice_class_table[conj] == 0xffff) {
+                flipslice_class_table[conj] = classes;
+                flipslice_sym_table[conj] = symmetry_inverses[sym];
+            }
+        }
+
+        classes++;
+
+    }
+
+    if(classes != FLIPSLICE_CLASSES) {
+        fprintf(stderr, "expected %d flip-slice classes, found %d\n", FLIPSLICE_CLASSES, classes);
+        exit(1);
+    }
+
+}
+
+int flipslice_class(int flipslice) {
+    return flipslice_class_table[flipslice];
+}
+
+int flipslice_sym(int flipslice) {
+    return flipslice_sym_table[flipslice];
+}
+
+int conjugate_co(int co, int sym) {
+    return co_conj_table[co * NUM_UD_SYMMETRIES + sym];
+}
+
+/*
+ * A class representative which is fixed by some symmetries has several table
+ * entries describing equivalent cubes (one for each way of conjugating CO by
+ * those symmetries). Only the one with the smallest CO is looked up, but
+ * symmetry_table_equivalents() lets generation fill in the others too, so
+ * that every entry of the table holds a distance.
+ */
+uint64_t symmetry_table_index(int flipslice, int co) {
+
+    int class = flipslice_class_table[flipslice];
+    co = co_conj_table[co * NUM_UD_SYMMETRIES + flipslice_sym_table[flipslice]];
+
+    int stabilizer = flipslice_stabilizers[class];
+    if(stabilizer != 1) {
+        int min_co = co;
+        for(int sym = 1; sym < NUM_UD_SYMMETRIES; sym++) {
+            if(stabilizer & (1 << sym)) {
+                int conj = co_conj_table[co * NUM_UD_SYMMETRIES + sym];
+                min_co = conj < min_co ? conj : min_co;
+            }
+        }
+        co = min_co;
+    }
+
+    return (uint64_t)class * 2187 + co;
+
+}
+
+int symmetry_table_equivalents(uint64_t index, uint64_t *out) {
+
+    int class = index / 2187, co = index % 2187;
+    int stabilizer = flipslice_stabilizers[class];
+
+    int count = 0;
+    for(int sym = 1; sym < NUM_UD_SYMMETRIES; sym++) {
+        if(!(stabilizer & (1 << sym))) continue;
+        uint64_t conj = (uint64_t)class * 2187 + co_conj_table[co * NUM_UD_SYMMETRIES + sym];
+        bool seen = conj == index;
+        for(int i = 0; i < count && !seen; i++) {
+            seen = out[i] == conj;
+        }
+        if(!seen) out[count++] = conj;
+    }
+
+    return count;
+
+}
+
+void symmetry_table_neighbours(uint64_t index, const int *moves, int num_moves, uint64_t *out) {
+
+    int flipslice = flipslice_reps[index / 2187], co = index % 2187;
+    int slice = flipslice / 2048, eo = flipslice % 2048;
+
+    for(int i = 0; i < num_moves; i++) {
+        int move = moves[i];
+        int next_slice = mult_eslice(slice * 24, move) / 24;
+        out[i] = symmetry_table_index(next_slice * 2048 + mult_eo(eo, move), mult_co(co, move));
+    }
+
+}
+
+// How to generate the table for `metric`, without checkpoints.
+void symmetry_table_spec(int metric, PruneSpec *spec) {
+    const int *moves;
+    int num_moves = metric_moves(metric, &moves);
+    *spec = (PruneSpec){FLIPSLICE_TABLE_SIZE, 0, moves, num_moves, symmetry_table_neighbours, NULL, FLIPSLICE_LAYOUT, symmetry_table_equivalents};
+}
+
+void init_symmetry_table(int flags, int num_threads) {
+
+    fprintf(stderr, "initializing symmetries...\n");
+    init_symmetries();
+    init_sym_coords();
+
+    const char *path = "flipslice.prune";
+    fprintf(stderr, "loading pruning table %s...\n", path);
+
+    int result = load_prune_table(&symmetry_table, path, FLIPSLICE_LAYOUT, FLIPSLICE_TABLE_SIZE, PRUNE_NIBBLE, flags);
+    if(result == PRUNE_OK) {
+        return;
+    }
+
+    fprintf(stderr, "couldn't load pruning table %s: %s\n", path, prune_error_string(result));
+    fprintf(stderr, "building symmetry-reduced pruning table...\n");
+
+    PruneSpec spec;
+    symmetry_table_spec(METRIC_HTM, &spec);
+    spec.path = path;
+
+    alloc_prune_table(&symmetry_table, FLIPSLICE_TABLE_SIZE, PRUNE_NIBBLE);
+    generate_prune_table(&spec, &symmetry_table, num_threads);
+    save_prune_table(&symmetry_table, path, FLIPSLICE_LAYOUT);
+
+}
+
+// Lower bound on the distance of a cube, from the symmetry-reduced table.
+int lookup_symmetry_table(CoordCube *cube) {
+    int flipslice = cube->e_edges / 24 * 2048 + cube->eo;
+    return prune_get(&symmetry_table, symmetry_table_index(flipslice, cube->co));
+}
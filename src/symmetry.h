@@ -0,0 +1,67 @@
+#ifndef __SYMMETRY_H
+#define __SYMMETRY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "cube.h"
+#include "coordinates.h"
+#include "prune.h"
+
+/*
+ * The cube has 48 symmetries: the 24 rotations of space which map the cube
+ * onto itself, and each of those combined with a reflection. If S is a
+ * symmetry and c is a cube state, the conjugate S*c*S^-1 is the state we
+ * would get by applying c to a cube that has been rotated or mirrored by S.
+ * Conjugation maps every face turn onto another face turn (reflections also
+ * swap clockwise and counter-clockwise), so a cube and all of its conjugates
+ * are the same number of moves away from being solved.
+ *
+ * We represent each symmetry as a Cube describing where it sends each cubie,
+ * like a move. Reflections reverse the sense in which corners are twisted,
+ * which we mark by adding 3 to their corner orientations (following
+ * Kociemba); these orientations only ever appear in the symmetry cubes.
+ *
+ * SYMMETRY REDUCTION
+ *
+ * A coordinate is compatible with a symmetry if the coordinate of S*c*S^-1 only
+ * depends on the coordinate of c. The 16 symmetries which keep the U-D axis
+ * in place (symmetries 0 through 15 here) are compatible with CO and with the
+ * flip-slice coordinate, which combines EO with the positions of the E-slice
+ * edges. We can then group flip-slice values into equivalence classes, and
+ * describe any flip-slice value by the index of its class plus the symmetry
+ * which maps it onto the class representative. Indexing a pruning table by
+ * class index and CO (conjugated by that same symmetry) gives a table 16
+ * times smaller than one indexed by the raw coordinates, with no loss of
+ * information.
+ *
+ * The table we build this way gives the distance to the subgroup
+ * <U,D,L2,R2,F2,B2>, which is a lower bound for the distance to the solved
+ * state.
+ */
+
+#define NUM_SYMMETRIES    48
+#define NUM_UD_SYMMETRIES 16
+
+#define FLIPSLICE_RAW     1013760 // 495 * 2048
+#define FLIPSLICE_CLASSES 64430
+
+// init_mult_tables() must have been called first
+void init_symmetries();
+void conjugate_cube(Cube *cube, int sym, Cube *result);
+int symmetry_inverse(int sym);
+const Cube *symmetry_cube(int sym);
+int conjugate_move(int move, int sym);
+int symmetry_face(int sym, int face);
+bool symmetry_is_mirror(int sym);
+
+void init_sym_coords();
+int flipslice_class(int flipslice);
+int flipslice_sym(int flipslice);
+int conjugate_co(int co, int sym);
+
+// init_symmetries() and init_sym_coords() must have been called first
+void symmetry_table_spec(int metric, PruneSpec *spec);
+void init_symmetry_table(int flags, int num_threads);
+int lookup_symmetry_table(CoordCube *cube);
+
+#endif
@@ -0,0 +1,249 @@
+#include "twophase.h"
+#include "coordinates.h"
+#include "cubevec.h"
+#include "cube.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SLICE_COMBS 495
+#define SLICE_PERMS 24
+#define MAX_LENGTH 30
+
+// pruning tables, indexed by first coordinate * size of second coordinate + second coordinate
+uint8_t *phase1_co_table;   // CO x E-slice position
+uint8_t *phase1_eo_table;   // EO x E-slice position
+uint8_t *phase2_cp_table;   // CP x E-slice permutation
+uint8_t *phase2_edge_table; // UD edge permutation x E-slice permutation
+
+const int phase1_moves[18] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17};
+const int phase2_moves[10] = {0, 1, 2, 3, 4, 5, 8, 11, 14, 17};
+
+typedef struct {
+    CubeVec cube;
+    int moves[MAX_LENGTH];
+    int best[MAX_LENGTH];
+    int best_length;
+    int max_length;
+    int time_limit_ms;
+    struct timespec start;
+    bool stop;
+} TwoPhaseSearch;
+
+// The E-slice coordinate is split into position * 24 + permutation (see coordinates.c)
+int mult_slice_comb(int comb, int move) {
+    return mult_eslice(comb * SLICE_PERMS, move) / SLICE_PERMS;
+}
+
+int mult_slice_perm(int perm, int move) {
+    return mult_eslice(perm, move);
+}
+
+/*
+ * Build a pruning table for a pair of coordinates by breadth-first search from
+ * the solved state, using the same table-scanning approach as the main pruning
+ * table. Both coordinates must be 0 when solved.
+ */
+void build_phase_table(uint8_t *table, int size1, int size2, int (*mult1)(int, int), int (*mult2)(int, int), const int *moves, int num_moves) {
+
+    int size = size1 * size2;
+    memset(table, 0xff, size);
+    table[0] = 0;
+
+    int depth = 0, filled = 1;
+    while(filled > 0) {
+        filled = 0;
+        for(int i = 0; i < size; i++) {
+            if(table[i] != depth) continue;
+            int coord1 = i / size2, coord2 = i % size2;
+            for(int j = 0; j < num_moves; j++) {
+                int next = mult1(coord1, moves[j]) * size2 + mult2(coord2, moves[j]);
+                if(table[next] == 0xff) {
+                    table[next] = depth + 1;
+                    filled++;
+                }
+            }
+        }
+        depth++;
+    }
+
+}
+
+void init_two_phase_tables() {
+
+    init_cube_vecs();
+
+    phase1_co_table = malloc(2187 * SLICE_COMBS);
+    phase1_eo_table = malloc(2048 * SLICE_COMBS);
+    phase2_cp_table = malloc(40320 * SLICE_PERMS);
+    phase2_edge_table = malloc(40320 * SLICE_PERMS);
+
+    build_phase_table(phase1_co_table, 2187, SLICE_COMBS, mult_co, mult_slice_comb, phase1_moves, 18);
+    build_phase_table(phase1_eo_table, 2048, SLICE_COMBS, mult_eo, mult_slice_comb, phase1_moves, 18);
+    build_phase_table(phase2_cp_table, 40320, SLICE_PERMS, mult_cp, mult_slice_perm, phase2_moves, 10);
+    build_phase_table(phase2_edge_table, 40320, SLICE_PERMS, mult_ud_edge, mult_slice_perm, phase2_moves, 10);
+
+}
+
+int phase1_heuristic(int co, int eo, int slice_comb) {
+    int h1 = phase1_co_table[co * SLICE_COMBS + slice_comb];
+    int h2 = phase1_eo_table[eo * SLICE_COMBS + slice_comb];
+    return h1 > h2 ? h1 : h2;
+}
+
+int phase2_heuristic(int cp, int ud_edge, int slice_perm) {
+    int h1 = phase2_cp_table[cp * SLICE_PERMS + slice_perm];
+    int h2 = phase2_edge_table[ud_edge * SLICE_PERMS + slice_perm];
+    return h1 > h2 ? h1 : h2;
+}
+
+int elapsed_ms(struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000 + (now.tv_nsec - start->tv_nsec) / 1000000;
+}
+
+bool phase2(TwoPhaseSearch *s, int cp, int ud_edge, int slice_perm, int last_face, int depth, int togo) {
+
+    if(togo == 0) {
+        return cp == 0 && ud_edge == 0 && slice_perm == 0;
+    }
+
+    for(int i = 0; i < 10; i++) {
+
+        int move = phase2_moves[i];
+        if(last_face != -1 && is_redundant(last_face, move / 3))
+            continue;
+
+        int next_cp = mult_cp(cp, move),
+            next_ud_edge = mult_ud_edge(ud_edge, move),
+            next_slice_perm = mult_slice_perm(slice_perm, move);
+
+        if(phase2_heuristic(next_cp, next_ud_edge, next_slice_perm) >= togo)
+            continue;
+
+        s->moves[depth] = move;
+        if(phase2(s, next_cp, next_ud_edge, next_slice_perm, move / 3, depth + 1, togo - 1)) {
+            return true;
+        }
+
+    }
+
+    return false;
+
+}
+
+void start_phase2(TwoPhaseSearch *s, int phase1_length) {
+
+    // Phase 2 needs coordinates we don't track in phase 1, so replay the moves.
+    CubeVec vec = s->cube;
+    for(int i = 0; i < phase1_length; i++) {
+        vec_move(&vec, s->moves[i]);
+    }
+    Cube cube = vec_to_cube(&vec);
+
+    int cp = compute_cp_coord(&cube),
+        ud_edge = compute_ud_edge_coord(&cube),
+        slice_perm = compute_eslice_coord(&cube);
+
+    // only accept solutions shorter than the best one so far
+    int max_phase2 = s->best_length - 1 - phase1_length;
+    int last_face = phase1_length > 0 ? s->moves[phase1_length - 1] / 3 : -1;
+
+    for(int depth = phase2_heuristic(cp, ud_edge, slice_perm); depth <= max_phase2; depth++) {
+        if(phase2(s, cp, ud_edge, slice_perm, last_face, phase1_length, depth)) {
+            s->best_length = phase1_length + depth;
+            memcpy(s->best, s->moves, s->best_length * sizeof(int));
+            if(s->best_length <= s->max_length) {
+                s->stop = true;
+            }
+            break;
+        }
+    }
+
+    if(s->time_limit_ms >= 0 && elapsed_ms(&s->start) >= s->time_limit_ms) {
+        s->stop = true;
+    }
+
+}
+
+void phase1(TwoPhaseSearch *s, int co, int eo, int slice_comb, int last_face, int depth, int togo) {
+
+    if(togo == 0) {
+
+        /*
+         * If the last move was a phase 2 move, the cube was already in H one
+         * move ago, and that shorter phase 1 solution has been tried before.
+         */
+        if(depth > 0 && is_phase2_move(s->moves[depth - 1]))
+            return;
+
+        start_phase2(s, depth);
+        return;
+
+    }
+
+    for(int face = 0; face < 6; face++) {
+
+        if(last_face != -1 && is_redundant(last_face, face))
+            continue;
+
+        for(int degree = 0; degree < 3; degree++) {
+
+            int move = move_to_int(face, degree);
+            int next_co = mult_co(co, move),
+                next_eo = mult_eo(eo, move),
+                next_slice_comb = mult_slice_comb(slice_comb, move);
+
+            if(phase1_heuristic(next_co, next_eo, next_slice_comb) >= togo)
+                continue;
+
+            s->moves[depth] = move;
+            phase1(s, next_co, next_eo, next_slice_comb, face, depth + 1, togo - 1);
+            if(s->stop) {
+                return;
+            }
+
+        }
+
+    }
+
+}
+
+/*
+ * Solve a cube using the two-phase algorithm. The search stops as soon as a
+ * solution of at most `max_length` moves is found, or when `time_limit_ms`
+ * milliseconds have passed (a negative limit means no limit). Returns the
+ * length of the shortest solution found, or -1 if there was none.
+ */
+int solve_two_phase(Cube *cube, int max_length, int time_limit_ms, int *solution) {
+
+    TwoPhaseSearch search;
+    TwoPhaseSearch *s = &search;
+    s->cube = cube_to_vec(cube);
+    s->best_length = MAX_LENGTH + 1;
+    s->max_length = max_length;
+    s->time_limit_ms = time_limit_ms;
+    s->stop = false;
+    clock_gettime(CLOCK_MONOTONIC, &s->start);
+
+    int co = compute_co_coord(cube),
+        eo = compute_eo_coord(cube),
+        slice_comb = compute_eslice_coord(cube) / SLICE_PERMS;
+
+    for(int depth = phase1_heuristic(co, eo, slice_comb); depth < s->best_length && !s->stop; depth++) {
+        phase1(s, co, eo, slice_comb, -1, 0, depth);
+    }
+
+    int length = -1;
+    if(s->best_length <= MAX_LENGTH) {
+        length = s->best_length;
+        memcpy(solution, s->best, length * sizeof(int));
+    }
+
+    return length;
+
+}
@@ -0,0 +1,29 @@
+#ifndef __TWOPHASE_H
+#define __TWOPHASE_H
+
+#include "cube.h"
+
+/*
+ * Optimal solving is expensive, so for most purposes we'd rather find a
+ * reasonably short solution quickly. Kociemba's two-phase algorithm does this
+ * by splitting the solve around the subgroup H = <U,D,L2,R2,F2,B2>.
+ *
+ * In phase 1, we search for a sequence of moves that brings the cube into H.
+ * A cube is in H exactly when its corner and edge orientations are solved and
+ * the E-slice edges are in the E-slice, so phase 1 only needs the CO, EO and
+ * E-slice coordinates. In phase 2, we solve the cube using only moves from H,
+ * which means we need to track the corner permutation, the permutation of the
+ * U and D layer edges and the permutation of the E-slice edges.
+ *
+ * Both phases are searched using IDA*. The pruning tables for each phase are
+ * pairs of coordinates (e.g. CO x E-slice position), which are small enough
+ * to be generated in a fraction of a second at startup. Every phase 1
+ * solution leads to a full solution, but not necessarily a short one. We
+ * therefore keep searching longer phase 1 solutions with shorter phase 2
+ * solutions until we find a short enough solution or run out of time.
+ */
+
+void init_two_phase_tables();
+int solve_two_phase(Cube *cube, int max_length, int time_limit_ms, int *solution);
+
+#endif
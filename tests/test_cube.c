@@ -0,0 +1,283 @@
+/*
+ * Checks the cube group operations in cube.c against do_move(), which turns
+ * faces directly and doesn't depend on them. init_move_cubes() has to be
+ * called first: until then move_cubes is all zeros, and multiplying by it
+ * silently gives wrong cubes rather than failing.
+ *
+ * Also checks that facelet strings round-trip, match get_cube_colors() and
+ * are rejected with the right error code when they describe illegal cubes,
+ * and that cube ranks and state files round-trip.
+ *
+ * The vectorized cube of cubevec.h is checked against the same operations.
+ * Its kernels are inline, so they are compiled for whatever instruction set
+ * this file is; CMake builds it a second time without SSSE3 (defining
+ * TEST_SCALAR_VEC) so that the fallback is tested as well.
+ */
+#include "cube.h"
+#include "cubevec.h"
+#include "random.h"
+#include "statefile.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(TEST_SCALAR_VEC) && defined(__SSSE3__)
+#error "TEST_SCALAR_VEC needs to be compiled without SSSE3"
+#endif
+
+#define NUM_STATES       20000
+#define STATE_FILE_CUBES 100
+
+int failures = 0;
+
+bool cubes_equal(Cube *a, Cube *b) {
+    return memcmp(a, b, sizeof(Cube)) == 0;
+}
+
+void check(bool ok, const char *what, int state) {
+    if(!ok) {
+        if(failures < 10) {
+            fprintf(stderr, "FAIL: %s (state %d)\n", what, state);
+        }
+        failures++;
+    }
+}
+
+// Apply a sequence of moves, or its inverse (the inverse moves in reverse order).
+void apply_sequence(Cube *cube, const int *moves, int length, bool inverse) {
+    for(int i = 0; i < length; i++) {
+        int move = inverse ? moves[length - 1 - i] : moves[i];
+        int degree = move % 3;
+        if(inverse && degree != TURN_FLIP) {
+            degree = degree == TURN_CW ? TURN_CCW : TURN_CW;
+        }
+        do_move(cube, move / 3, degree);
+    }
+}
+
+/*
+ * Facelet strings of known cubes, and strings which are each wrong in one way
+ * (all derived from the solved cube), with the error they should give.
+ */
+const char *solved_facelets = "BBBBBBBBBOOOWWWRRRYYYOOOWWWRRRYYYOOOWWWRRRYYYGGGGGGGGG";
+const char *r_facelets      = "BBWBBWBBWOOOWWGRRRBYYOOOWWGRRRBYYOOOWWGRRRBYYGGYGGYGGY";
+
+const struct {
+    const char *facelets;
+    int error;
+} bad_facelets[] = {
+    {"BBBBBBBBBOOOWWWRRRYYYOOOWWWRRRYYYOOOWWWRRRYYYGGGGGGGG", CUBE_ERROR_LENGTH},
+    {"BBBBBBBBBOOOWWWRRRYYYOOOWWWRRRYYYOOOWWWRRRYYYGGGGGGGGGG", CUBE_ERROR_LENGTH},
+    {"BBBBBBBBBOOOWWWRRRYYYOOOWWWRRRYYYOOOWWWRRRYYYGGGGGGGGX", CUBE_ERROR_COLOR},
+    {"BBBBGBBBBOOOWWWRRRYYYOOOWWWRRRYYYOOOWWWRRRYYYGGGGGGGGG", CUBE_ERROR_CENTER},       // wrong center
+    {"BBBBBBBBBOOOWWWRRRYYYOOOWWWRRRYYYOOBWWWRRRYYYOGGGGGGGG", CUBE_ERROR_CORNERS},      // duplicate corner
+    {"BBBBBBOBBOOWBWWRRRYYYOOOWWWRRRYYYOOOWWWRRRYYYGGGGGGGGG", CUBE_ERROR_TWISTED_CORNER},
+    {"BBBBBBBBBOOOWWWRRRYYYOOWOWWRRRYYYOOOWWWRRRYYYGGGGGGGGG", CUBE_ERROR_FLIPPED_EDGE},
+    {"BBBBBBBBBOOOWWWRRRYYYOORWWWORRYYYOOOWWWRRRYYYGGGGGGGGG", CUBE_ERROR_PARITY},       // two edges swapped
+};
+
+void check_facelets() {
+
+    char facelets[FACELET_STRING_SIZE], colors[54];
+    Cube cube = create_solved_cube(), parsed;
+
+    write_facelets(&cube, facelets);
+    check(strcmp(facelets, solved_facelets) == 0, "solved cube writes the expected facelets", 0);
+    do_move(&cube, FACE_R, TURN_CW);
+    write_facelets(&cube, facelets);
+    check(strcmp(facelets, r_facelets) == 0, "R writes the expected facelets", 0);
+    check(parse_facelets(&parsed, r_facelets) == CUBE_VALID && cubes_equal(&parsed, &cube), "R parses back from its facelets", 0);
+
+    // write_facelets() is get_cube_colors() plus a terminator
+    const char *sequences[] = {"U", "F2 L'", "R U R' U' B D2", "L2 F' D B2 U R' F L D'"};
+    for(int i = 0; i < 4; i++) {
+        cube = create_solved_cube();
+        check(do_moves(&cube, sequences[i], NULL) == CUBE_VALID, "test sequence parses", i);
+        write_facelets(&cube, facelets);
+        get_cube_colors(&cube, colors);
+        check(memcmp(facelets, colors, 54) == 0 && facelets[54] == '\0', "write_facelets matches get_cube_colors", i);
+    }
+
+    for(int i = 0; i < (int)(sizeof(bad_facelets) / sizeof(bad_facelets[0])); i++) {
+        check(parse_facelets(&parsed, bad_facelets[i].facelets) == bad_facelets[i].error, "bad facelets give the expected error", i);
+    }
+
+    // errors which can't come from a facelet string, only from a Cube
+    const int expected[7] = {
+        CUBE_ERROR_CORNERS, CUBE_ERROR_EDGES, CUBE_ERROR_CORNER_ORIENTATION, CUBE_ERROR_EDGE_ORIENTATION,
+        CUBE_ERROR_TWISTED_CORNER, CUBE_ERROR_FLIPPED_EDGE, CUBE_ERROR_PARITY
+    };
+    Cube bad[7];
+    for(int i = 0; i < 7; i++) bad[i] = create_solved_cube();
+    bad[0].corners[1] = bad[0].corners[0];
+    bad[1].edges[1] = bad[1].edges[0];
+    bad[2].corner_orientations[0] = 3;
+    bad[3].edge_orientations[0] = 2;
+    bad[4].corner_orientations[0] = 1;
+    bad[5].edge_orientations[0] = 1;
+    bad[6].edges[0] = 1;
+    bad[6].edges[1] = 0;
+    for(int i = 0; i < 7; i++) {
+        check(validate_cube(&bad[i]) == expected[i], "validate_cube gives the expected error", i);
+    }
+
+}
+
+void check_ranks() {
+
+    Cube solved = create_solved_cube(), cube = solved;
+    CubeRank rank = rank_cube(&solved);
+    check(rank.low == 0 && rank.high == 0, "the solved cube has rank 0", 0);
+
+    // the last rank is the largest valid one, and it ranks back to itself
+    CubeRank last = {CUBE_STATES_LOW - 1, CUBE_STATES_HIGH}, end = {CUBE_STATES_LOW, CUBE_STATES_HIGH};
+    check(unrank_cube(last, &cube), "unrank_cube accepts CUBE_STATES - 1", 0);
+    rank = rank_cube(&cube);
+    check(rank.low == last.low && rank.high == last.high, "CUBE_STATES - 1 round-trips", 0);
+    check(validate_cube(&cube) == CUBE_VALID, "CUBE_STATES - 1 is a legal cube", 0);
+
+    cube = solved;
+    CubeRank high = {0, CUBE_STATES_HIGH + 1};
+    check(!unrank_cube(end, &cube), "unrank_cube rejects CUBE_STATES", 0);
+    check(!unrank_cube(high, &cube), "unrank_cube rejects a larger high word", 0);
+    check(cubes_equal(&cube, &solved), "rejected ranks leave the cube alone", 0);
+
+}
+
+/*
+ * Write cubes to a state file and read them back, with solutions (including
+ * one record without a solution) or without.
+ */
+void check_state_file(Rng *rng, uint32_t flags) {
+
+    Cube cubes[STATE_FILE_CUBES];
+    int solutions[STATE_FILE_CUBES][STATE_MAX_MOVES], lengths[STATE_FILE_CUBES];
+
+    FILE *fp = tmpfile();
+    if(fp == NULL) {
+        perror("tmpfile");
+        failures++;
+        return;
+    }
+
+    StateFile file;
+    check(write_state_header(&file, fp, flags) == STATE_OK, "state file header is written", 0);
+    for(int i = 0; i < STATE_FILE_CUBES; i++) {
+        cubes[i] = create_random_cube(rng);
+        lengths[i] = i == 3 ? -1 : i % (STATE_MAX_MOVES + 1);
+        for(int j = 0; j < lengths[i]; j++) {
+            solutions[i][j] = rng_below(rng, 18);
+        }
+        check(write_state(&file, &cubes[i], solutions[i], lengths[i]) == STATE_OK, "state is written", i);
+    }
+
+    rewind(fp);
+    check(read_state_header(&file, fp) == STATE_OK && file.flags == flags, "state file header is read back", 0);
+    for(int i = 0; i < STATE_FILE_CUBES; i++) {
+        Cube cube;
+        int solution[STATE_MAX_MOVES], length;
+        check(read_state(&file, &cube, solution, &length) == STATE_OK, "state is read back", i);
+        check(cubes_equal(&cube, &cubes[i]), "state file cube round-trips", i);
+        if(flags & STATE_FILE_SOLUTIONS) {
+            check(length == lengths[i], "state file solution length round-trips", i);
+            check(length <= 0 || memcmp(solution, solutions[i], length * sizeof(int)) == 0, "state file solution round-trips", i);
+        } else {
+            check(length == -1, "state file without solutions reads no solution", i);
+        }
+    }
+
+    Cube cube;
+    check(read_state(&file, &cube, NULL, NULL) == STATE_END, "state file ends after the last record", 0);
+    fclose(fp);
+
+}
+
+int main() {
+
+    init_move_cubes();
+    init_cube_vecs();
+
+    Rng rng;
+    seed_rng(&rng, 1);
+    Cube solved = create_solved_cube();
+
+    for(int state = 0; state < NUM_STATES; state++) {
+
+        Cube cube = create_random_cube(&rng);
+
+        // multiplying by a move cube is the same as turning the face
+        for(int move = 0; move < 18; move++) {
+            Cube expected = cube, product, moved = cube;
+            do_move(&expected, move / 3, move % 3);
+            cube_multiply(&cube, &move_cubes[move], &product);
+            cube_move(&moved, move);
+            check(cubes_equal(&product, &expected), "cube_multiply by a move cube matches do_move", state);
+            check(cubes_equal(&moved, &expected), "cube_move matches do_move", state);
+        }
+
+        // the same for the vectorized cube, comparing every byte including the unused ones
+        CubeVec vec = cube_to_vec(&cube);
+        for(int move = 0; move < 18; move++) {
+            Cube expected = cube;
+            do_move(&expected, move / 3, move % 3);
+            CubeVec moved = vec, expected_vec = cube_to_vec(&expected);
+            vec_move(&moved, move);
+            check(memcmp(&moved, &expected_vec, sizeof(CubeVec)) == 0, "vec_move matches do_move", state);
+        }
+
+        Cube other = create_random_cube(&rng), cube_product;
+        cube_multiply(&cube, &other, &cube_product);
+        CubeVec other_vec = cube_to_vec(&other), product_vec, expected_vec = cube_to_vec(&cube_product);
+        vec_multiply(&vec, &other_vec, &product_vec);
+        check(memcmp(&product_vec, &expected_vec, sizeof(CubeVec)) == 0, "vec_multiply matches cube_multiply", state);
+        Cube back = vec_to_cube(&product_vec);
+        check(cubes_equal(&back, &cube_product), "vec_to_cube inverts cube_to_vec", state);
+
+        // c * c^-1 and c^-1 * c are solved
+        Cube inverse, product;
+        cube_inverse(&cube, &inverse);
+        cube_multiply(&cube, &inverse, &product);
+        check(cubes_equal(&product, &solved), "c * c^-1 is the identity", state);
+        cube_multiply(&inverse, &cube, &product);
+        check(cubes_equal(&product, &solved), "c^-1 * c is the identity", state);
+
+        // ranks round-trip
+        Cube unranked;
+        check(unrank_cube(rank_cube(&cube), &unranked) && cubes_equal(&unranked, &cube), "unrank_cube(rank_cube(c)) is c", state);
+
+        // facelet strings round-trip
+        char facelets[FACELET_STRING_SIZE];
+        Cube parsed;
+        write_facelets(&cube, facelets);
+        check(parse_facelets(&parsed, facelets) == CUBE_VALID && cubes_equal(&parsed, &cube), "facelets round-trip", state);
+
+        // s * c * s^-1, with s and c given as move sequences applied by hand
+        int s_moves[8], c_moves[12];
+        for(int i = 0; i < 8; i++) s_moves[i] = rng_below(&rng, 18);
+        for(int i = 0; i < 12; i++) c_moves[i] = rng_below(&rng, 18);
+
+        Cube s = solved, c = solved, expected = solved, conjugate;
+        apply_sequence(&s, s_moves, 8, false);
+        apply_sequence(&c, c_moves, 12, false);
+        apply_sequence(&expected, s_moves, 8, false);
+        apply_sequence(&expected, c_moves, 12, false);
+        apply_sequence(&expected, s_moves, 8, true);
+        cube_conjugate(&c, &s, &conjugate);
+        check(cubes_equal(&conjugate, &expected), "cube_conjugate matches s * c * s^-1 applied by hand", state);
+
+    }
+
+    check_facelets();
+    check_ranks();
+    check_state_file(&rng, 0);
+    check_state_file(&rng, STATE_FILE_SOLUTIONS);
+
+    if(failures > 0) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+
+    printf("all checks passed on %d states\n", NUM_STATES);
+    return 0;
+
+}